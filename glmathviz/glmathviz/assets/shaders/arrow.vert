@@ -1,35 +1,54 @@
 #version 330 core
 
-layout (location = 0) in vec4 dimensions;
+// instance attributes
+layout (location = 0) in vec4 dimensions; // magnitude, arm radius, head radius, head height
 layout (location = 1) in mat4 modelMat;
 layout (location = 5) in mat3 normModelMat;
 layout (location = 8) in vec3 diffuse;
-layout (location = 9) in vec4 specular;
+layout (location = 9) in vec4 specular; // vec3 specular, float shininess
+// unit arrow vertex (see ArrowMesh): direction around the axis, part (0 arm base, 1 arm top, 2 head base, 3 tip)
+layout (location = 10) in vec3 unit;
 
-out VS_OUT {
-	float mag;
-	float armRadius;
-	float headRadius;
-	float headHeight;
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
 
-	mat4 model;
-	mat3 normalModel;
-
-	vec3 diffuse;
-	vec3 specular;
-	float shininess;
-} vs_out;
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
 
 void main() {
-	vs_out.mag = dimensions.x;
-	vs_out.armRadius = dimensions.y;
-	vs_out.headRadius = dimensions.z;
-	vs_out.headHeight = dimensions.w;
+	float mag = dimensions.x;
+	float armRadius = dimensions.y;
+	float headRadius = dimensions.z;
+	float headHeight = dimensions.w;
+
+	// arrow with base in the XZ plane (y = 0) and arm along the y axis
+	int part = int(unit.z + 0.5);
+	vec3 local;
+	vec3 localNormal;
+	if (part < 2) {
+		local = vec3(armRadius * unit.x, part == 1 ? mag - headHeight : 0.0, armRadius * unit.y);
+		localNormal = vec3(unit.x, 0.0, unit.y);
+	}
+	else {
+		local = part == 2 ? vec3(headRadius * unit.x, mag - headHeight, headRadius * unit.y) : vec3(0.0, mag, 0.0);
+		localNormal = vec3(headHeight * unit.x, headRadius, headHeight * unit.y);
+	}
+
+	// transform to world space
+	vec4 worldPos = modelMat * vec4(local, 1.0);
+	fragPos = worldPos.xyz;
+	normal = normModelMat * localNormal;
 
-	vs_out.model = modelMat;
-	vs_out.normalModel = normModelMat;
+	tex = vec2(0.0);
+	diffMap = diffuse;
+	specMap = specular.rgb;
+	shininess = specular.a;
 
-	vs_out.diffuse = diffuse;
-	vs_out.specular = specular.xyz;
-	vs_out.shininess = specular.w;
+	gl_Position = projView * worldPos;
 }
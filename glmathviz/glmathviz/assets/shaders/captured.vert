@@ -0,0 +1,31 @@
+#version 330 core
+
+// vertices captured from a geometry shader (see FeedbackCapture), already in world space
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 norm;
+layout (location = 2) in vec3 diffuse;
+layout (location = 3) in vec3 specular;
+layout (location = 4) in float shine;
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+
+void main() {
+	tex = vec2(0.0);
+	fragPos = pos;
+	normal = norm;
+	diffMap = diffuse;
+	specMap = specular;
+	shininess = shine;
+
+	gl_Position = projView * vec4(pos, 1.0);
+}
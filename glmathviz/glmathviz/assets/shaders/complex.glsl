@@ -0,0 +1,83 @@
+// complex arithmetic on vec2 (real, imaginary), float precision
+// - included into generated shaders (see ComplexPlane), no version directive
+
+vec2 cx_mul(vec2 a, vec2 b) {
+	return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+vec2 cx_div(vec2 a, vec2 b) {
+	return vec2(a.x * b.x + a.y * b.y, a.y * b.x - a.x * b.y) / dot(b, b);
+}
+
+vec2 cx_exp(vec2 z) {
+	return exp(z.x) * vec2(cos(z.y), sin(z.y));
+}
+
+vec2 cx_log(vec2 z) {
+	return vec2(log(length(z)), atan(z.y, z.x));
+}
+
+vec2 cx_pow(vec2 a, vec2 b) {
+	if (a == vec2(0.0)) {
+		// 0 for Re(b) > 0, a pole for Re(b) < 0, 1 for b = 0 and undefined for the rest of Re(b) = 0
+		if (b.x != 0.0) {
+			return b.x > 0.0 ? vec2(0.0) : vec2(1.0 / 0.0);
+		}
+		return b.y == 0.0 ? vec2(1.0, 0.0) : vec2(0.0 / 0.0);
+	}
+	return cx_exp(cx_mul(b, cx_log(a)));
+}
+
+vec2 cx_sqrt(vec2 z) {
+	float r = length(z);
+	return vec2(sqrt(0.5 * (r + z.x)), (z.y < 0.0 ? -1.0 : 1.0) * sqrt(0.5 * (r - z.x)));
+}
+
+vec2 cx_sin(vec2 z) {
+	return vec2(sin(z.x) * cosh(z.y), cos(z.x) * sinh(z.y));
+}
+
+vec2 cx_cos(vec2 z) {
+	return vec2(cos(z.x) * cosh(z.y), -sin(z.x) * sinh(z.y));
+}
+
+vec2 cx_tan(vec2 z) {
+	return cx_div(cx_sin(z), cx_cos(z));
+}
+
+vec2 cx_sinh(vec2 z) {
+	return vec2(sinh(z.x) * cos(z.y), cosh(z.x) * sin(z.y));
+}
+
+vec2 cx_cosh(vec2 z) {
+	return vec2(cosh(z.x) * cos(z.y), sinh(z.x) * sin(z.y));
+}
+
+vec2 cx_tanh(vec2 z) {
+	return cx_div(cx_sinh(z), cx_cosh(z));
+}
+
+// asin z = -i log(iz + sqrt(1 - z^2))
+vec2 cx_asin(vec2 z) {
+	vec2 w = cx_log(vec2(-z.y, z.x) + cx_sqrt(vec2(1.0, 0.0) - cx_mul(z, z)));
+	return vec2(w.y, -w.x);
+}
+
+vec2 cx_acos(vec2 z) {
+	return vec2(1.57079632679, 0.0) - cx_asin(z);
+}
+
+// atan z = i/2 log((i + z) / (i - z))
+vec2 cx_atan(vec2 z) {
+	vec2 w = cx_log(cx_div(vec2(z.x, 1.0 + z.y), vec2(-z.x, 1.0 - z.y)));
+	return 0.5 * vec2(-w.y, w.x);
+}
+
+// modulus as a real value, and the unit vector in the direction of z
+vec2 cx_abs(vec2 z) {
+	return vec2(length(z), 0.0);
+}
+
+vec2 cx_sign(vec2 z) {
+	return z == vec2(0.0) ? z : normalize(z);
+}
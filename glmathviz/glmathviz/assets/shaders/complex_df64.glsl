@@ -0,0 +1,128 @@
+// complex values C for ComplexPlane, emulated double precision (follows complex.glsl)
+// - each part is an unevaluated float sum hi + lo (about 48 bit mantissa)
+// - arithmetic and integer powers are exact to that precision, other functions run on the float value
+
+#define C vec4 // real hi, real lo, imaginary hi, imaginary lo
+
+// the error terms cancel algebraically, so they must not be reassociated
+// - precise needs GL_ARB_gpu_shader5 (enabled by ComplexPlane after the version directive)
+#ifdef GL_ARB_gpu_shader5
+#define DF_PRECISE precise
+#else
+#define DF_PRECISE
+#endif
+
+/*
+	double-float arithmetic on vec2 (hi, lo)
+*/
+
+// a + b as hi + lo exactly
+vec2 df_twoSum(float a, float b) {
+	DF_PRECISE float s = a + b;
+	DF_PRECISE float v = s - a;
+	DF_PRECISE float e = (a - (s - v)) + (b - v);
+	return vec2(s, e);
+}
+
+// a + b as hi + lo exactly, given |a| >= |b|
+vec2 df_quickTwoSum(float a, float b) {
+	DF_PRECISE float s = a + b;
+	DF_PRECISE float e = b - (s - a);
+	return vec2(s, e);
+}
+
+// split into two halves of 12 bits
+vec2 df_split(float a) {
+	DF_PRECISE float t = 4097.0 * a;
+	DF_PRECISE float hi = t - (t - a);
+	DF_PRECISE float lo = a - hi;
+	return vec2(hi, lo);
+}
+
+// a * b as hi + lo exactly
+vec2 df_twoProd(float a, float b) {
+	DF_PRECISE float p = a * b;
+	vec2 as = df_split(a);
+	vec2 bs = df_split(b);
+	DF_PRECISE float e = ((as.x * bs.x - p) + as.x * bs.y + as.y * bs.x) + as.y * bs.y;
+	return vec2(p, e);
+}
+
+vec2 df_add(vec2 a, vec2 b) {
+	vec2 s = df_twoSum(a.x, b.x);
+	return df_quickTwoSum(s.x, s.y + a.y + b.y);
+}
+
+vec2 df_mul(vec2 a, vec2 b) {
+	vec2 p = df_twoProd(a.x, b.x);
+	return df_quickTwoSum(p.x, p.y + a.x * b.y + a.y * b.x);
+}
+
+vec2 df_div(vec2 a, vec2 b) {
+	float q1 = a.x / b.x;
+	vec2 r = df_add(a, -df_mul(b, vec2(q1, 0.0)));
+	return df_quickTwoSum(q1, r.x / b.x);
+}
+
+/*
+	complex layer
+*/
+
+C cfrom(vec2 z) { return vec4(z.x, 0.0, z.y, 0.0); }
+
+C cconst(float hi, float lo) { return vec4(hi, lo, 0.0, 0.0); }
+C cimag() { return vec4(0.0, 0.0, 1.0, 0.0); }
+
+// float value for coloring, and the point at offset from the view center (real hi, lo, imaginary hi, lo)
+vec2 cvalue(C z) { return vec2(z.x + z.y, z.z + z.w); }
+C cposition(vec4 center, vec2 offset) {
+	return vec4(df_add(center.xy, vec2(offset.x, 0.0)), df_add(center.zw, vec2(offset.y, 0.0)));
+}
+
+C cadd(C a, C b) { return vec4(df_add(a.xy, b.xy), df_add(a.zw, b.zw)); }
+C csub(C a, C b) { return vec4(df_add(a.xy, -b.xy), df_add(a.zw, -b.zw)); }
+C cneg(C a) { return -a; }
+
+C cmul(C a, C b) {
+	return vec4(
+		df_add(df_mul(a.xy, b.xy), -df_mul(a.zw, b.zw)),
+		df_add(df_mul(a.xy, b.zw), df_mul(a.zw, b.xy)));
+}
+
+C cdiv(C a, C b) {
+	vec2 denom = df_add(df_mul(b.xy, b.xy), df_mul(b.zw, b.zw));
+	return vec4(
+		df_div(df_add(df_mul(a.xy, b.xy), df_mul(a.zw, b.zw)), denom),
+		df_div(df_add(df_mul(a.zw, b.xy), -df_mul(a.xy, b.zw)), denom));
+}
+
+C cpowi(C a, int n) {
+	C ret = vec4(1.0, 0.0, 0.0, 0.0);
+	C b = a;
+	for (int e = abs(n); e > 0; e >>= 1) {
+		if ((e & 1) != 0) {
+			ret = cmul(ret, b);
+		}
+		b = cmul(b, b);
+	}
+	return n < 0 ? cdiv(vec4(1.0, 0.0, 0.0, 0.0), ret) : ret;
+}
+
+C cpow(C a, C b) { return cfrom(cx_pow(cvalue(a), cvalue(b))); }
+C cexp(C z) { return cfrom(cx_exp(cvalue(z))); }
+C clog(C z) { return cfrom(cx_log(cvalue(z))); }
+C csqrt(C z) { return cfrom(cx_sqrt(cvalue(z))); }
+C csin(C z) { return cfrom(cx_sin(cvalue(z))); }
+C ccos(C z) { return cfrom(cx_cos(cvalue(z))); }
+C ctan(C z) { return cfrom(cx_tan(cvalue(z))); }
+C csinh(C z) { return cfrom(cx_sinh(cvalue(z))); }
+C ccosh(C z) { return cfrom(cx_cosh(cvalue(z))); }
+C ctanh(C z) { return cfrom(cx_tanh(cvalue(z))); }
+C casin(C z) { return cfrom(cx_asin(cvalue(z))); }
+C cacos(C z) { return cfrom(cx_acos(cvalue(z))); }
+C catan(C z) { return cfrom(cx_atan(cvalue(z))); }
+C cabs(C z) { return cfrom(cx_abs(cvalue(z))); }
+C csign(C z) { return cfrom(cx_sign(cvalue(z))); }
+C cfloor(C z) { return cfrom(floor(cvalue(z))); }
+C cceil(C z) { return cfrom(ceil(cvalue(z))); }
+C cround(C z) { return cfrom(floor(cvalue(z) + 0.5)); }
@@ -0,0 +1,47 @@
+// complex values C for ComplexPlane, float precision (follows complex.glsl)
+
+#define C vec2
+
+C cconst(float hi, float lo) { return vec2(hi + lo, 0.0); }
+C cimag() { return vec2(0.0, 1.0); }
+
+// float value for coloring, and the point at offset from the view center (real hi, lo, imaginary hi, lo)
+vec2 cvalue(C z) { return z; }
+C cposition(vec4 center, vec2 offset) { return vec2(center.x + center.y, center.z + center.w) + offset; }
+
+C cadd(C a, C b) { return a + b; }
+C csub(C a, C b) { return a - b; }
+C cneg(C a) { return -a; }
+C cmul(C a, C b) { return cx_mul(a, b); }
+C cdiv(C a, C b) { return cx_div(a, b); }
+
+C cpowi(C a, int n) {
+	C ret = vec2(1.0, 0.0);
+	C b = a;
+	for (int e = abs(n); e > 0; e >>= 1) {
+		if ((e & 1) != 0) {
+			ret = cmul(ret, b);
+		}
+		b = cmul(b, b);
+	}
+	return n < 0 ? cdiv(vec2(1.0, 0.0), ret) : ret;
+}
+
+C cpow(C a, C b) { return cx_pow(a, b); }
+C cexp(C z) { return cx_exp(z); }
+C clog(C z) { return cx_log(z); }
+C csqrt(C z) { return cx_sqrt(z); }
+C csin(C z) { return cx_sin(z); }
+C ccos(C z) { return cx_cos(z); }
+C ctan(C z) { return cx_tan(z); }
+C csinh(C z) { return cx_sinh(z); }
+C ccosh(C z) { return cx_cosh(z); }
+C ctanh(C z) { return cx_tanh(z); }
+C casin(C z) { return cx_asin(z); }
+C cacos(C z) { return cx_acos(z); }
+C catan(C z) { return cx_atan(z); }
+C cabs(C z) { return cx_abs(z); }
+C csign(C z) { return cx_sign(z); }
+C cfloor(C z) { return floor(z); }
+C cceil(C z) { return ceil(z); }
+C cround(C z) { return floor(z + 0.5); }
@@ -0,0 +1,37 @@
+#version 330 core
+
+in vec2 ndc;
+
+out vec4 fragColor;
+
+// half width and height of the view (complex plane units)
+uniform vec2 extent;
+
+// f at the point offset from the view center
+// - generated from the expression and linked as a separate shader object (see ComplexPlane)
+vec2 evaluate(vec2 offset);
+
+vec3 hsv2rgb(vec3 c) {
+	vec3 rgb = clamp(abs(mod(c.x * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+	return c.z * mix(vec3(1.0), rgb, c.y);
+}
+
+void main() {
+	vec2 w = evaluate(ndc * extent);
+	float modulus = length(w);
+
+	// zeros black, poles and undefined points white
+	if (modulus == 0.0) {
+		fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+		return;
+	}
+	if (isinf(modulus) || isnan(modulus)) {
+		fragColor = vec4(1.0);
+		return;
+	}
+
+	// hue from the argument, brightness ramps between powers of two of the modulus
+	float hue = fract(atan(w.y, w.x) / 6.28318530718);
+	float brightness = 0.7 + 0.3 * fract(log2(modulus));
+	fragColor = vec4(hsv2rgb(vec3(hue, 0.9, brightness)), 1.0);
+}
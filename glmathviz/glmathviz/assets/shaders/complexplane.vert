@@ -0,0 +1,11 @@
+#version 330 core
+
+// position in normalized device coordinates
+out vec2 ndc;
+
+// fullscreen triangle, no attributes (see ComplexPlane)
+// - drawn just in front of the far plane, behind the 3D programs
+void main() {
+	ndc = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+	gl_Position = vec4(ndc, 0.99999, 1.0);
+}
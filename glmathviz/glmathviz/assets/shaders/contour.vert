@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+
+void main() {
+	// lines lie on the surface, pulled slightly towards the camera so they win the depth test
+	gl_Position = projView * vec4(pos, 1.0);
+	gl_Position.z -= 0.0002 * gl_Position.w;
+}
@@ -7,7 +7,12 @@ in vec3 diffMap;
 in vec3 specMap;
 in float shininess;
 
-uniform vec3 viewPos;
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+
+uniform bool twoSided; // light back faces with the flipped normal
 
 out vec4 fragColor;
 
@@ -28,7 +33,13 @@ vec4 calcDirLight(DirLight dirLight, vec3 norm, vec3 viewVec, vec4 diffMap, vec4
 void main() {
 	fragColor = vec4(0.0, 0.0, 0.0, 1.0);
 
-	fragColor += calcDirLight(dirLight, normalize(normal), normalize(viewPos - fragPos), vec4(diffMap, 1.0), vec4(specMap, 1.0));
+	// flipped per fragment, a per vertex flip would interpolate through zero across silhouettes
+	vec3 norm = normalize(normal);
+	if (twoSided && !gl_FrontFacing) {
+		norm = -norm;
+	}
+
+	fragColor += calcDirLight(dirLight, norm, normalize(viewPos - fragPos), vec4(diffMap, 1.0), vec4(specMap, 1.0));
 }
 
 vec4 calcDirLight(DirLight dirLight, vec3 norm, vec3 viewDir, vec4 diffMap, vec4 specMap) {
@@ -0,0 +1,31 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 norm;
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+uniform vec3 diffuse;
+uniform vec4 specular; // vec3 specular, float shininess
+
+void main() {
+	// triangles are already in world space (see ImplicitMesher)
+	tex = vec2(0.0);
+	fragPos = pos;
+	normal = norm;
+
+	diffMap = diffuse;
+	specMap = specular.rgb;
+	shininess = specular.a;
+
+	gl_Position = projView * vec4(fragPos, 1.0);
+}
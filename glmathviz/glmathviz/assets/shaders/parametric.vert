@@ -0,0 +1,48 @@
+#version 330 core
+
+// instance attributes, the grid position comes from the index
+layout (location = 0) in vec4 bounds; // u min, v min, u max, v max
+layout (location = 1) in vec3 diffuse;
+layout (location = 2) in vec4 specular; // vec3 specular, float shininess
+layout (location = 3) in vec3 offset;
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+uniform int u_cells;
+uniform int v_cells;
+
+// surface (x, y, z) = param(u, v) and its partial derivatives
+// - generated from the component expressions and linked as a separate shader object (see ParametricSurface)
+vec3 param(float u, float v);
+vec3 paramDu(float u, float v);
+vec3 paramDv(float u, float v);
+
+void main() {
+	// grid coordinates of this vertex (index = u * (v_cells + 1) + v)
+	int i = gl_VertexID / (v_cells + 1);
+	int j = gl_VertexID % (v_cells + 1);
+	tex = vec2(float(i) / float(u_cells), float(j) / float(v_cells));
+
+	float u = mix(bounds.x, bounds.z, tex.x);
+	float v = mix(bounds.y, bounds.w, tex.y);
+	fragPos = param(u, v) + offset;
+
+	// normal from the tangent vectors, on the front side of the grid's triangles
+	// - non-orientable surfaces have no consistent side, dirlight.frag flips it on back faces (twoSided)
+	normal = cross(paramDu(u, v), paramDv(u, v));
+
+	diffMap = diffuse;
+	specMap = specular.rgb;
+	shininess = specular.a;
+
+	gl_Position = projView * vec4(fragPos, 1.0);
+}
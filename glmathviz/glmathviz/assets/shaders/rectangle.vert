@@ -4,7 +4,10 @@ layout (location = 0) in vec3 pos;
 
 out vec3 fragPos;
 
-uniform mat4 projView;
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
 
 void main() {
 	// projection * view * model * vec4(pos, 1.0)
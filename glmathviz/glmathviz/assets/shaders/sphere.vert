@@ -14,7 +14,10 @@ out vec3 diffMap;
 out vec3 specMap;
 out float shininess;
 
-uniform mat4 projView;
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
 
 void main() {
 	tex = texCoord;
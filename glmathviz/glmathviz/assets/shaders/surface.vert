@@ -3,12 +3,18 @@
 layout (location = 0) in vec4 bounds;
 layout (location = 1) in vec3 diffuse;
 layout (location = 2) in vec4 specular;
+// chunks only (0 otherwise): first cell (x, z), 1, 0
+layout (location = 3) in vec4 lattice;
+// chunks only: cells across bounds (x, z)
+layout (location = 4) in vec2 lattice_cells;
 
 out VS_OUT {
 	int idx;
 
 	vec2 minBound;
 	vec2 maxBound;
+	vec4 lattice;
+	vec2 lattice_cells;
 
 	vec3 diffuse;
 	vec3 specular;
@@ -20,6 +26,8 @@ void main() {
 
 	vs_out.minBound = bounds.xy;
 	vs_out.maxBound = bounds.zw;
+	vs_out.lattice = lattice;
+	vs_out.lattice_cells = lattice_cells;
 
 	vs_out.diffuse = diffuse;
 	vs_out.specular = specular.rgb;
@@ -0,0 +1,40 @@
+#version 330 core
+
+// one texel per grid vertex: (normal, y)
+out vec4 texel;
+
+uniform vec4 bounds; // of the instance being baked
+uniform int x_cells;
+uniform int z_cells;
+uniform bool calculus;
+
+// surface y = f(x, z) and its normal vector
+// - generated from the surface expression and linked as a separate shader object (see Surface)
+float func(float x, float z);
+vec3 funcNorm(vec3 p);
+
+void main() {
+	// grid vertex of this texel
+	ivec2 idx = ivec2(gl_FragCoord.xy);
+	vec2 tex = vec2(float(idx.x) / float(x_cells), float(idx.y) / float(z_cells));
+
+	float x = mix(bounds.x, bounds.z, tex.x);
+	float z = mix(bounds.y, bounds.w, tex.y);
+	vec3 pos = vec3(x, func(x, z), z);
+
+	vec3 normal;
+	if (calculus) {
+		// calculus to calculate normal vector
+		normal = funcNorm(pos);
+	}
+	else {
+		// cross product with the neighbouring vertices
+		float x_inc = (bounds.z - bounds.x) / float(x_cells);
+		float z_inc = (bounds.w - bounds.y) / float(z_cells);
+		vec3 p01 = vec3(x, func(x, z + z_inc), z + z_inc);
+		vec3 p10 = vec3(x + x_inc, func(x + x_inc, z), z);
+		normal = cross(p01 - pos, p10 - pos);
+	}
+
+	texel = vec4(normal, pos.y);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+
+// fullscreen triangle, no attributes (see HeightField)
+void main() {
+	vec2 pos = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+	gl_Position = vec4(pos, 0.0, 1.0);
+}
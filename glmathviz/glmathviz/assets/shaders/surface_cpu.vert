@@ -0,0 +1,42 @@
+#version 330 core
+
+// instance attributes, the grid position comes from the index
+layout (location = 0) in vec4 bounds;
+layout (location = 1) in vec3 diffuse;
+layout (location = 2) in vec4 specular; // vec3 specular, float shininess
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+uniform int x_cells;
+uniform int z_cells;
+
+// heights and normals evaluated on the CPU (see SurfaceEvaluator)
+// - one (y, normal.x, normal.z, 0) texel per vertex, instances stored one after another
+uniform samplerBuffer heights;
+
+void main() {
+	// grid coordinates of this vertex (index = x * (z_cells + 1) + z)
+	int i = gl_VertexID / (z_cells + 1);
+	int j = gl_VertexID % (z_cells + 1);
+	tex = vec2(float(i) / float(x_cells), float(j) / float(z_cells));
+
+	vec4 sample = texelFetch(heights, gl_InstanceID * (x_cells + 1) * (z_cells + 1) + gl_VertexID);
+
+	fragPos = vec3(mix(bounds.x, bounds.z, tex.x), sample.x, mix(bounds.y, bounds.w, tex.y));
+	normal = vec3(sample.y, 1.0, sample.z);
+
+	diffMap = diffuse;
+	specMap = specular.rgb;
+	shininess = specular.a;
+
+	gl_Position = projView * vec4(fragPos, 1.0);
+}
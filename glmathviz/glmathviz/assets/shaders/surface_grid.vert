@@ -0,0 +1,81 @@
+#version 330 core
+
+// instance attributes, the grid position comes from the index
+layout (location = 0) in vec4 bounds;
+layout (location = 1) in vec3 diffuse;
+layout (location = 2) in vec4 specular; // vec3 specular, float shininess
+// patches only (0 otherwise): first lattice vertex (x, z), lattice steps per cell, stitch flags
+layout (location = 3) in vec4 lattice;
+// patches only: finest lattice cells across bounds (x, z)
+layout (location = 4) in vec2 lattice_cells;
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+uniform int x_cells;
+uniform int z_cells;
+uniform bool calculus;
+
+// surface y = f(x, z) and its normal vector
+// - generated from the surface expression and linked as a separate shader object (see Surface)
+float func(float x, float z);
+vec3 funcNorm(vec3 p);
+
+void main() {
+	// grid coordinates of this vertex (index = x * (z_cells + 1) + z)
+	int i = gl_VertexID / (z_cells + 1);
+	int j = gl_VertexID % (z_cells + 1);
+	tex = vec2(float(i) / float(x_cells), float(j) / float(z_cells));
+
+	float x;
+	float z;
+	float x_inc = (bounds.z - bounds.x) / float(x_cells);
+	float z_inc = (bounds.w - bounds.y) / float(z_cells);
+	if (lattice.z > 0.0) {
+		// odd vertices on an edge shared with a coarser patch collapse onto its vertices (no T-junctions)
+		int flags = int(lattice.w);
+		if ((((flags & 1) != 0 && i == 0) || ((flags & 2) != 0 && i == x_cells)) && j % 2 == 1) {
+			j--;
+		}
+		else if ((((flags & 4) != 0 && j == 0) || ((flags & 8) != 0 && j == z_cells)) && i % 2 == 1) {
+			i--;
+		}
+
+		// position on the shared lattice, so neighbouring patches compute identical vertices
+		// - clamped to the instance, chunks may overhang its edges
+		x = mix(bounds.x, bounds.z, clamp(lattice.x + float(i) * lattice.z, 0.0, lattice_cells.x) / lattice_cells.x);
+		z = mix(bounds.y, bounds.w, clamp(lattice.y + float(j) * lattice.z, 0.0, lattice_cells.y) / lattice_cells.y);
+		x_inc = (bounds.z - bounds.x) * lattice.z / lattice_cells.x;
+		z_inc = (bounds.w - bounds.y) * lattice.z / lattice_cells.y;
+	}
+	else {
+		x = mix(bounds.x, bounds.z, tex.x);
+		z = mix(bounds.y, bounds.w, tex.y);
+	}
+	fragPos = vec3(x, func(x, z), z);
+
+	if (calculus) {
+		// calculus to calculate normal vector
+		normal = funcNorm(fragPos);
+	}
+	else {
+		// cross product with the neighbouring vertices
+		vec3 p01 = vec3(x, func(x, z + z_inc), z + z_inc);
+		vec3 p10 = vec3(x + x_inc, func(x + x_inc, z), z);
+		normal = cross(p01 - fragPos, p10 - fragPos);
+	}
+
+	diffMap = diffuse;
+	specMap = specular.rgb;
+	shininess = specular.a;
+
+	gl_Position = projView * vec4(fragPos, 1.0);
+}
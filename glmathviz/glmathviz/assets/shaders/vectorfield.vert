@@ -0,0 +1,91 @@
+#version 330 core
+
+// unit arrow vertex (see ArrowMesh): direction around the axis, part (0 arm base, 1 arm top, 2 head base, 3 tip)
+layout (location = 0) in vec3 unit;
+
+out vec2 tex;
+out vec3 fragPos;
+out vec3 normal;
+out vec3 diffMap;
+out vec3 specMap;
+out float shininess;
+
+layout (std140) uniform CameraUniform {
+	mat4 projView;
+	vec3 viewPos;
+};
+uniform vec3 samples; // lattice points per axis
+uniform vec3 minCorner;
+uniform vec3 spacing; // between lattice points
+uniform float magnitudeScale; // magnitude drawn at full length
+uniform float maxLength;
+uniform vec3 shape; // arm radius, head radius, head height of a full length arrow
+uniform vec4 specular; // vec3 specular, float shininess
+
+// field vector at a point
+// - generated from the component expressions and linked as a separate shader object (see VectorField)
+vec3 field(vec3 p);
+
+// blue (weak) through green to red (strong)
+vec3 magnitudeColor(float m) {
+	return clamp(vec3(1.5) - abs(4.0 * m - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);
+}
+
+void main() {
+	tex = vec2(0.0);
+	specMap = specular.rgb;
+	shininess = specular.a;
+
+	// lattice point of this instance (index = (z * ny + y) * nx + x)
+	ivec3 n = ivec3(samples);
+	ivec3 idx = ivec3(gl_InstanceID % n.x, (gl_InstanceID / n.x) % n.y, gl_InstanceID / (n.x * n.y));
+	vec3 center = minCorner + vec3(idx) * spacing;
+
+	vec3 F = field(center);
+	float mag = length(F);
+	float m = clamp(mag / magnitudeScale, 0.0, 1.0);
+	float len = m * maxLength;
+	diffMap = magnitudeColor(m);
+
+	if (!(len > 0.0)) {
+		// zero or undefined, every vertex on one point so nothing is rasterized
+		fragPos = center;
+		normal = vec3(0.0, 1.0, 0.0);
+		gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+		return;
+	}
+
+	// branchless orthonormal basis around the direction (Duff et al. 2017), arrow y along the field
+	vec3 dir = F / mag;
+	float s = dir.z >= 0.0 ? 1.0 : -1.0;
+	float a = -1.0 / (s + dir.z);
+	float b = dir.x * dir.y * a;
+	mat3 frame = mat3(
+		vec3(1.0 + s * dir.x * dir.x * a, s * b, -s * dir.x),
+		dir,
+		vec3(b, s + dir.y * dir.y * a, -dir.y));
+
+	// constant thickness, arrows shorter than two heads shrink as a whole
+	float headHeight = min(shape.z, 0.5 * len);
+	float k = headHeight / shape.z;
+	float armRadius = k * shape.x;
+	float headRadius = k * shape.y;
+
+	int part = int(unit.z + 0.5);
+	vec3 local;
+	vec3 localNormal;
+	if (part < 2) {
+		local = vec3(armRadius * unit.x, part == 1 ? len - headHeight : 0.0, armRadius * unit.y);
+		localNormal = vec3(unit.x, 0.0, unit.y);
+	}
+	else {
+		local = part == 2 ? vec3(headRadius * unit.x, len - headHeight, headRadius * unit.y) : vec3(0.0, len, 0.0);
+		localNormal = vec3(headHeight * unit.x, headRadius, headHeight * unit.y);
+	}
+
+	// centered on the lattice point, the frame is orthonormal so it also transforms the normal
+	fragPos = center + frame * (local - vec3(0.0, 0.5 * len, 0.0));
+	normal = frame * localNormal;
+
+	gl_Position = projView * vec4(fragPos, 1.0);
+}
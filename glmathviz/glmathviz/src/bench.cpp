@@ -0,0 +1,489 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+// headless context, no windowing system required
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "scene.hpp"
+
+#include "io/camera.h"
+#include "io/keyboard.h"
+
+#include "profiling/glstats.h"
+#include "profiling/programtimer.h"
+#include "profiling/tracer.h"
+
+/*
+	headless benchmark runner
+	- renders the scene graph into an offscreen framebuffer through an EGL context
+	- steps a fixed number of frames with a fixed dt
+	- writes per-frame and per-program timings as JSON
+	  (CPU times per frame, plus rolling CPU/GPU statistics from ProgramTimer)
+	- reports the mean GL call and upload counts per frame from GLStats
+	- with --eval N, first compares surface evaluation over an N x N grid
+	  (SurfaceEvaluator single threaded and on the pool, against surface.geom on the GPU)
+
+	- --scene picks one of sceneNames (default surface)
+
+	usage: glmathviz-bench [--scene NAME] [--frames N] [--warmup N] [--dt S] [--width W] [--height H] [--out FILE] [--trace FILE] [--eval N]
+*/
+
+std::string Shader::defaultDirectory = "assets/shaders";
+
+typedef std::chrono::steady_clock Clock;
+
+// benchmark parameters
+typedef struct {
+	const char* scene;
+	unsigned int frames;
+	unsigned int warmup;
+	double dt;
+	int width;
+	int height;
+	const char* out;
+	const char* trace;
+	int evalCells;
+} BenchConfig;
+
+// timings for one program over all recorded frames (milliseconds)
+typedef struct {
+	std::vector<double> update;
+	std::vector<double> render;
+} ProgramSamples;
+
+// headless context
+EGLDisplay display = EGL_NO_DISPLAY;
+EGLContext context = EGL_NO_CONTEXT;
+
+// offscreen framebuffer
+GLuint fbo = 0;
+GLuint colorRbo = 0;
+GLuint depthRbo = 0;
+
+bool parseArgs(int argc, char** argv, BenchConfig& config);
+bool createContext();
+void destroyContext();
+bool createFramebuffer(int width, int height);
+void benchEvaluation(int cells);
+void destroyFramebuffer();
+void writeReport(std::ostream& out, BenchConfig& config,
+	std::vector<double>& frameTimes, std::vector<ProgramSamples>& programTimes, GLFrameStats& glTotals);
+
+double elapsedMs(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+	BenchConfig config = { sceneNames[0], 300, 10, 1.0 / 60.0, 800, 800, nullptr, nullptr, 0 };
+	if (!parseArgs(argc, argv, config)) {
+		return -1;
+	}
+
+	if (config.trace) {
+		Tracer::start(config.trace);
+	}
+
+	// initialize
+	if (!createContext()) {
+		std::cerr << "Could not create headless context" << std::endl;
+		destroyContext();
+		return -1;
+	}
+
+	// load glad
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cerr << "Could not load GLAD" << std::endl;
+		destroyContext();
+		return -1;
+	}
+
+	std::cerr << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+	if (!createFramebuffer(config.width, config.height)) {
+		std::cerr << "Could not create offscreen framebuffer" << std::endl;
+		destroyFramebuffer();
+		destroyContext();
+		return -1;
+	}
+
+	// rendering parameters
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, config.width, config.height);
+
+	// setup scene
+	if (!loadScene(config.scene)) {
+		destroyFramebuffer();
+		destroyContext();
+		return -1;
+	}
+	writeViewport(config.width, config.height);
+
+	// fixed camera, same start position as the app
+	Camera cam(glm::vec3(-2.0f, 0.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(
+		glm::radians(cam.getZoom()),					// FOV
+		(float)config.width / (float)config.height,	// aspect ratio
+		0.1f, 100.0f									// near/far bounds
+	);
+	writeCamera(projection * cam.getViewMatrix(), cam.cameraPos);
+
+	if (config.evalCells > 0) {
+		benchEvaluation(config.evalCells);
+	}
+
+	// start animations as if T was pressed
+	Keyboard::keyCallback(nullptr, GLFW_KEY_T, 0, GLFW_PRESS, 0);
+	transitionPath->toggleRunning();
+	for (Program* program : programs) {
+		program->keyChanged(nullptr, GLFW_KEY_T, 0, GLFW_PRESS, 0);
+	}
+	Keyboard::clearKeysChanged();
+
+	// timing storage
+	GLFrameStats glTotals = { 0 };
+	std::vector<double> frameTimes;
+	std::vector<ProgramSamples> programTimes(programs.size());
+	frameTimes.reserve(config.frames);
+	for (ProgramSamples& timings : programTimes) {
+		timings.update.reserve(config.frames);
+		timings.render.reserve(config.frames);
+	}
+
+	// discard startup traffic from the GL counters
+	GLStats::endFrame();
+
+	for (unsigned int frame = 0; frame < config.warmup + config.frames; frame++) {
+		bool record = frame >= config.warmup;
+		Clock::time_point frameStart = Clock::now();
+		TRACE_SCOPE("frame", "frame");
+
+		// update
+		{
+			TRACE_SCOPE("Transition::update", "update");
+			transitionPath->update(config.dt);
+		}
+		ProgramTimer::updateAll(config.dt);
+		for (unsigned int i = 0; i < ProgramTimer::timers.size(); i++) {
+			if (record) {
+				programTimes[i].update.push_back(ProgramTimer::timers[i].cpuUpdate.last);
+			}
+		}
+
+		// rendering
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		for (unsigned int i = 0; i < ProgramTimer::timers.size(); i++) {
+			ProgramTimer::timers[i].render(drawQueue);
+			if (record) {
+				programTimes[i].render.push_back(ProgramTimer::timers[i].cpuRender.last);
+			}
+		}
+		drawQueue.flush();
+
+		// wait for the GPU so the frame time covers the whole frame
+		{
+			TRACE_SCOPE("glFinish", "render");
+			glFinish();
+		}
+
+		GLStats::endFrame();
+
+		if (record) {
+			frameTimes.push_back(elapsedMs(frameStart, Clock::now()));
+
+			glTotals.drawCalls += GLStats::last.drawCalls;
+			glTotals.programBinds += GLStats::last.programBinds;
+			glTotals.programSwitches += GLStats::last.programSwitches;
+			glTotals.vaoBinds += GLStats::last.vaoBinds;
+			glTotals.uniformSets += GLStats::last.uniformSets;
+			glTotals.uploads += GLStats::last.uploads;
+			glTotals.bytesUploaded += GLStats::last.bytesUploaded;
+		}
+	}
+
+	// report
+	if (config.out) {
+		std::ofstream file(config.out);
+		if (!file.is_open()) {
+			std::cerr << "Could not open " << config.out << std::endl;
+		}
+		else {
+			writeReport(file, config, frameTimes, programTimes, glTotals);
+		}
+	}
+	else {
+		writeReport(std::cout, config, frameTimes, programTimes, glTotals);
+	}
+
+	// write trace
+	Tracer::stop();
+
+	// cleanup
+	cleanupScene();
+	destroyFramebuffer();
+	destroyContext();
+
+	return 0;
+}
+
+bool parseArgs(int argc, char** argv, BenchConfig& config) {
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* val = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (!val) {
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+
+		if (!strcmp(arg, "--scene")) {
+			config.scene = val;
+		}
+		else if (!strcmp(arg, "--frames")) {
+			config.frames = (unsigned int)atoi(val);
+		}
+		else if (!strcmp(arg, "--warmup")) {
+			config.warmup = (unsigned int)atoi(val);
+		}
+		else if (!strcmp(arg, "--dt")) {
+			config.dt = atof(val);
+		}
+		else if (!strcmp(arg, "--width")) {
+			config.width = atoi(val);
+		}
+		else if (!strcmp(arg, "--height")) {
+			config.height = atoi(val);
+		}
+		else if (!strcmp(arg, "--out")) {
+			config.out = val;
+		}
+		else if (!strcmp(arg, "--trace")) {
+			config.trace = val;
+		}
+		else if (!strcmp(arg, "--eval")) {
+			config.evalCells = atoi(val);
+		}
+		else {
+			std::cerr << "Unknown argument " << arg << std::endl;
+			return false;
+		}
+
+		i++;
+	}
+
+	if (config.width <= 0 || config.height <= 0) {
+		std::cerr << "Invalid framebuffer size" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// print evaluation rate in vertices per second
+void printRate(const char* label, double vertices, double ms) {
+	std::cerr << "  " << label << ": " << ms << " ms, " << vertices / ms * 1000.0 << " vertices/s" << std::endl;
+}
+
+void benchEvaluation(int cells) {
+	const int repeats = 10;
+	glm::vec4 bounds(-10.0f, -10.0f, 10.0f, 10.0f);
+	double vertices = (double)(cells + 1) * (cells + 1);
+	std::vector<glm::vec4> out((cells + 1) * (cells + 1));
+
+	std::string error;
+	SurfaceEvaluator evaluator;
+	evaluator.setExpression(Expression::parse(surfacePresets[0], error));
+
+	std::cerr << "Surface evaluation (" << cells << " x " << cells << " cells, mean of " << repeats << ")" << std::endl;
+
+	// CPU, one thread then the shared pool
+	ThreadPool single(0);
+	ThreadPool* pools[] = { &single, &ThreadPool::shared() };
+	for (ThreadPool* pool : pools) {
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < repeats; i++) {
+			evaluator.evaluate(bounds, cells, cells, 0.0, 0.0, true, &out[0], *pool);
+		}
+		std::string label = "cpu, " + std::to_string(pool->size() + 1) + " thread(s)";
+		printRate(label.c_str(), vertices, elapsedMs(start, Clock::now()) / repeats);
+	}
+
+	// GPU, surface.geom drawing the same grid
+	Surface surface(1, cells, cells);
+	surface.addInstance(glm::vec2(bounds.x, bounds.y), glm::vec2(bounds.z, bounds.w), Material::yellow_plastic);
+	surface.load();
+
+	DrawQueue queue;
+	surface.render(queue);
+	queue.flush();
+	glFinish();
+
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < repeats; i++) {
+		surface.render(queue);
+		queue.flush();
+		glFinish();
+	}
+	printRate("gpu, geometry shader", vertices, elapsedMs(start, Clock::now()) / repeats);
+
+	surface.cleanup();
+}
+
+bool createContext() {
+	// prefer the surfaceless platform (no X/Wayland server on perf hosts)
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		return false;
+	}
+
+	// no surface needed, rendering goes to a framebuffer object
+	EGLint configAttribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig eglConfig = EGL_NO_CONFIG_KHR;
+	EGLint noConfigs = 0;
+	if (!eglChooseConfig(display, configAttribs, &eglConfig, 1, &noConfigs) || !noConfigs) {
+		// surfaceless displays may expose no GL configs (EGL_KHR_no_config_context)
+		eglConfig = EGL_NO_CONFIG_KHR;
+	}
+
+	// same version and profile as the app
+	EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	context = eglCreateContext(display, eglConfig, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT) {
+		return false;
+	}
+
+	return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+}
+
+void destroyContext() {
+	if (display == EGL_NO_DISPLAY) {
+		return;
+	}
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (context != EGL_NO_CONTEXT) {
+		eglDestroyContext(display, context);
+	}
+	eglTerminate(display);
+}
+
+bool createFramebuffer(int width, int height) {
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+	glGenRenderbuffers(1, &colorRbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRbo);
+
+	glGenRenderbuffers(1, &depthRbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRbo);
+
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void destroyFramebuffer() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(1, &colorRbo);
+	glDeleteRenderbuffers(1, &depthRbo);
+	glDeleteFramebuffers(1, &fbo);
+}
+
+void writeStats(std::ostream& out, const char* key, TimingStats stats) {
+	out << "\"" << key << "\": { \"min\": " << stats.min
+		<< ", \"mean\": " << stats.mean
+		<< ", \"p99\": " << stats.p99
+		<< ", \"count\": " << stats.count << " }";
+}
+
+void writeArray(std::ostream& out, std::vector<double>& vals) {
+	out << "[";
+	for (unsigned int i = 0; i < vals.size(); i++) {
+		out << (i ? ", " : "") << vals[i];
+	}
+	out << "]";
+}
+
+void writeReport(std::ostream& out, BenchConfig& config,
+	std::vector<double>& frameTimes, std::vector<ProgramSamples>& programTimes, GLFrameStats& glTotals) {
+	out << "{" << std::endl;
+	out << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\"," << std::endl;
+	out << "  \"scene\": \"" << config.scene << "\"," << std::endl;
+	out << "  \"frames\": " << config.frames << "," << std::endl;
+	out << "  \"warmup\": " << config.warmup << "," << std::endl;
+	out << "  \"dt\": " << config.dt << "," << std::endl;
+	out << "  \"width\": " << config.width << "," << std::endl;
+	out << "  \"height\": " << config.height << "," << std::endl;
+
+	out << "  \"frame_ms\": ";
+	writeArray(out, frameTimes);
+	out << "," << std::endl;
+
+	// mean GL traffic per recorded frame
+	double noFrames = config.frames ? (double)config.frames : 1.0;
+	out << "  \"gl_per_frame\": { "
+		<< "\"draw_calls\": " << glTotals.drawCalls / noFrames
+		<< ", \"program_binds\": " << glTotals.programBinds / noFrames
+		<< ", \"program_switches\": " << glTotals.programSwitches / noFrames
+		<< ", \"vao_binds\": " << glTotals.vaoBinds / noFrames
+		<< ", \"uniform_sets\": " << glTotals.uniformSets / noFrames
+		<< ", \"uploads\": " << glTotals.uploads / noFrames
+		<< ", \"bytes_uploaded\": " << glTotals.bytesUploaded / noFrames
+		<< " }," << std::endl;
+
+	out << "  \"programs\": [" << std::endl;
+	for (unsigned int i = 0; i < programTimes.size(); i++) {
+		out << "    { \"name\": \"" << programNames[i] << "\"," << std::endl;
+		out << "      \"update_ms\": ";
+		writeArray(out, programTimes[i].update);
+		out << "," << std::endl;
+		out << "      \"render_ms\": ";
+		writeArray(out, programTimes[i].render);
+		out << "," << std::endl;
+
+		// rolling statistics over the last TIMER_WINDOW frames
+		ProgramTimings timings = ProgramTimer::timers[i].getTimings();
+		out << "      \"rolling\": {" << std::endl << "        ";
+		writeStats(out, "cpu_update", timings.cpuUpdate);
+		out << "," << std::endl << "        ";
+		writeStats(out, "cpu_render", timings.cpuRender);
+		out << "," << std::endl << "        ";
+		writeStats(out, "gpu_update", timings.gpuUpdate);
+		out << "," << std::endl << "        ";
+		writeStats(out, "gpu_render", timings.gpuRender);
+		out << " } }" << (i + 1 < programTimes.size() ? "," : "") << std::endl;
+	}
+	out << "  ]" << std::endl;
+	out << "}" << std::endl;
+}
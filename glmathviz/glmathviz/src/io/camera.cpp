@@ -12,7 +12,8 @@ Camera::Camera(glm::vec3 position)
     speed(2.5f),
     sensitivity(1.0f),
     zoom(45.0f),
-    cameraFront(glm::vec3(1.0f, 0.0f, 0.0f))
+    cameraFront(glm::vec3(1.0f, 0.0f, 0.0f)),
+    vectorsDirty(false)
 {
     updateCameraVectors();
 }
@@ -33,13 +34,16 @@ void Camera::updateCameraDirection(double dx, double dy) {
         pitch = -89.0f;
     }
 
-    updateCameraVectors();
+    // defer trigonometry until the vectors are needed
+    vectorsDirty = true;
 }
 
 // change camera position in certain direction (keyboard)
 void Camera::updateCameraPos(CameraDirection direction, double dt) {
     float velocity = (float)dt * speed;
 
+    refreshCameraVectors();
+
     switch (direction) {
     case CameraDirection::FORWARD:
         cameraPos += cameraFront * velocity;
@@ -81,6 +85,7 @@ void Camera::updateCameraZoom(double dy) {
 
 // get view matrix for camera
 glm::mat4 Camera::getViewMatrix() {
+    refreshCameraVectors();
     return glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 }
 
@@ -103,4 +108,12 @@ void Camera::updateCameraVectors() {
 
     cameraRight = glm::normalize(glm::cross(cameraFront, glm::vec3(0.0f, 1.0f, 0.0f)));
     cameraUp = glm::normalize(glm::cross(cameraRight, cameraFront));
+}
+
+// rebuild directional vectors if the direction changed
+void Camera::refreshCameraVectors() {
+    if (vectorsDirty) {
+        updateCameraVectors();
+        vectorsDirty = false;
+    }
 }
\ No newline at end of file
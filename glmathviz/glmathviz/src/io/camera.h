@@ -59,6 +59,7 @@ public:
     */
 
     // change camera direction (mouse movement)
+    // - yaw/pitch are applied immediately, directional vectors are rebuilt on next use
     void updateCameraDirection(double dx, double dy);
 
     // change camera position in certain direction (keyboard)
@@ -78,12 +79,18 @@ public:
     float getZoom();
 
 private:
+    // if yaw/pitch changed since the directional vectors were computed
+    bool vectorsDirty;
+
     /*
         private modifier
     */
 
     // change camera directional vectors based on movement
     void updateCameraVectors();
+
+    // rebuild directional vectors if the direction changed
+    void refreshCameraVectors();
 };
 
 #endif
\ No newline at end of file
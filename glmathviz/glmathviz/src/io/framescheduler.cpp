@@ -0,0 +1,31 @@
+#include "framescheduler.h"
+
+/*
+    define initial static values
+*/
+
+double FrameScheduler::nextWake = 0.0; // render the first frame immediately
+
+/*
+    requests
+*/
+
+void FrameScheduler::wakeIn(double seconds) {
+    if (seconds < nextWake) {
+        nextWake = seconds > 0.0 ? seconds : 0.0;
+    }
+}
+
+void FrameScheduler::wakeNow() {
+    nextWake = 0.0;
+}
+
+/*
+    waiting
+*/
+
+double FrameScheduler::takeTimeout() {
+    double ret = nextWake;
+    nextWake = never;
+    return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <limits>
+
+/*
+    frame scheduler class to decide how long the main loop may sleep
+    - the loop requests wakes while finishing a frame, then waits for input or the earliest one
+    - with no request the loop blocks until the next event
+*/
+
+class FrameScheduler {
+public:
+    // no wake needed (scene is static)
+    static constexpr double never = std::numeric_limits<double>::infinity();
+
+    /*
+        requests
+    */
+
+    // request the next frame in _seconds_ (earliest request wins)
+    static void wakeIn(double seconds);
+
+    // request the next frame immediately
+    static void wakeNow();
+
+    /*
+        waiting
+    */
+
+    // seconds the loop may sleep waiting for events (0 = poll, never = block), clears requests
+    static double takeTimeout();
+
+private:
+    // seconds until the earliest requested wake
+    static double nextWake;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "keyboard.h"
 
+#include <string.h>
+
 /*
     define initial static values
 */
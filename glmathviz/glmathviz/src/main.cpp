@@ -4,19 +4,17 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include "rendering/shader.h"
-#include "rendering/uniformmemory.hpp"
-
-#include "programs/arrow.hpp"
-#include "programs/rectangle.hpp"
-#include "programs/sphere.hpp"
-#include "programs/surface.hpp"
-#include "programs/path.hpp"
+#include "scene.hpp"
 
 #include "io/camera.h"
+#include "io/framescheduler.h"
 #include "io/keyboard.h"
 #include "io/mouse.h"
 
+#include "profiling/glstats.h"
+#include "profiling/programtimer.h"
+#include "profiling/tracer.h"
+
 std::string Shader::defaultDirectory = "assets/shaders";
 
 // initialization methods
@@ -28,6 +26,8 @@ void createWindow(GLFWwindow*& window,
 // callback signatures
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void processInput(double dt);
+void scheduleFrame();
+void cameraMoved();
 void updateCameraMatrices();
 void keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods);
 void cursorChanged(GLFWwindow* window, double _x, double _y);
@@ -38,44 +38,23 @@ void scrollChanged(GLFWwindow* window, double dx, double dy);
 int scr_width = 800, scr_height = 800;
 GLFWwindow* window = nullptr;
 bool re_render = true;
+bool cameraChanged = true;
 
 // CAMERA
 Camera cam(glm::vec3(-2.0f, 0.0f, 0.0f));
 glm::mat4 view;
 glm::mat4 projection;
+// keys read every frame in processInput
+const int movementKeys[] = {
+	GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_A, GLFW_KEY_SPACE, GLFW_KEY_LEFT_SHIFT
+};
 
-// GLOBAL PROGRAMS
-std::vector<Program*> programs;
-Rectangle rect;
-Arrow arrow(5);
-Surface surface(5, 500, 500);
-//Transition<glm::vec3>* transitionPath = new CubicBezierPath<glm::vec3>(
-//	glm::vec3(0.0f),
-//	glm::vec3(1.0f),
-//	glm::vec3(-3.0f, -1.0f, 2.5f),
-//	glm::vec3(2.0f),
-//	3.0);
-glm::vec3 func(double t) {
-	return { 0.0, 3*cos(t) - 3.0, sin(t) };
-}
-ParametrizedPath* transitionPath = new ParametrizedPath(
-	func,
-	0.0, glm::two_pi<double>(),
-	2.0
-	);
-Sphere sphere(transitionPath, 10);
-Path path(transitionPath, 200);
-
-typedef struct {
-	glm::vec3 dir;
-	glm::vec4 ambient;
-	glm::vec4 diffuse;
-	glm::vec4 specular;
-} DirLight;
-
-int main() {
+int main(int argc, char** argv) {
 	std::cout << "Hello, math!" << std::endl;
 
+	// opt-in tracing (GLMATHVIZ_TRACE=trace.json)
+	Tracer::startFromEnv();
+
 	// initialize
 	initGLFW(3, 3);
 	createWindow(window, "GLMathViz", scr_width, scr_height, framebufferSizeCallback);
@@ -110,104 +89,90 @@ int main() {
 	Mouse::mouseButtonCallbacks.push_back(mouseButtonChanged);
 	Mouse::mouseWheelCallbacks.push_back(scrollChanged);
 
-	// generate instances
-	arrow.addInstance(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0125f, 0.025f, 0.15f, Material::red_plastic);
-	arrow.addInstance(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0125f, 0.025f, 0.15f, Material::green_plastic);
-	arrow.addInstance(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0125f, 0.025f, 0.15f, Material::cyan_plastic);
-	sphere.addInstance(glm::vec3(0.0f), glm::vec3(0.05f), Material::bronze);
-	surface.addInstance(glm::vec2(-10.f), glm::vec2(10.f), Material::yellow_plastic);
-	//surface.addInstance(glm::vec2(-2.5f, -100.0f), glm::vec2(2.5f, -2.5f), Material::red_plastic);
-	//surface.addInstance(glm::vec2(-2.5f, -100.0f), glm::vec2(-50.0f, 100.0f), Material::jade);
-
-	// register programs
-	programs.push_back(&arrow);
-	programs.push_back(&path);
-	programs.push_back(&sphere);
-	programs.push_back(&surface);
-	//programs.push_back(&rect);
-
-	transitionPath->setCyclical();
-
-	// setup programs
-	for (Program* program : programs) {
-		program->load();
-	}
-
-	// lighting
-	DirLight dirLight = {
-		glm::vec3(-0.2f, -0.9f, -0.2f),
-		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
-		glm::vec4(0.75f, 0.75f, 0.75f, 1.0f),
-		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)
-	};
-	// write to UBO
-	UBO::UBO dirLightUBO({
-		UBO::newStruct({
-			UBO::Type::VEC3,
-			UBO::Type::VEC4,
-			UBO::Type::VEC4,
-			UBO::Type::VEC4
-		})
-	});
-	for (Program* program : programs) {
-		dirLightUBO.attachToShader(program->shader, "DirLightUniform");
+	// setup scene (name in the first argument, see sceneNames)
+	if (!loadScene(argc > 1 ? argv[1] : sceneNames[0])) {
+		glfwTerminate();
+		return -1;
 	}
-	// generate/bind
-	dirLightUBO.generate();
-	dirLightUBO.bind();
-	dirLightUBO.initNullData(GL_STATIC_DRAW);
-	dirLightUBO.bindRange();
-	// write
-	dirLightUBO.startWrite();
-	dirLightUBO.writeElement<glm::vec3>(&dirLight.dir);
-	dirLightUBO.writeElement<glm::vec4>(&dirLight.ambient);
-	dirLightUBO.writeElement<glm::vec4>(&dirLight.diffuse);
-	dirLightUBO.writeElement<glm::vec4>(&dirLight.specular);
+	writeViewport(scr_width, scr_height);
 
 	// timing variables
 	double dt = 0.0;
 	double lastFrame = 0.0;
 
-	updateCameraMatrices();
-
 	while (!glfwWindowShouldClose(window)) {
+		TRACE_SCOPE("frame", "frame");
+
+		// input (sleeps until an event or the next scheduled change)
+		{
+			double timeout = FrameScheduler::takeTimeout();
+			if (timeout <= 0.0) {
+				TRACE_SCOPE("glfwPollEvents", "input");
+				glfwPollEvents();
+			}
+			else if (timeout == FrameScheduler::never) {
+				TRACE_SCOPE("glfwWaitEvents", "input");
+				glfwWaitEvents();
+				// idle time does not advance animations
+				lastFrame = glfwGetTime();
+			}
+			else {
+				TRACE_SCOPE("glfwWaitEventsTimeout", "input");
+				glfwWaitEventsTimeout(timeout);
+			}
+		}
+
 		// update time
 		dt = glfwGetTime() - lastFrame;
 		lastFrame += dt;
 
-		// input
-		glfwWaitEventsTimeout(0.001);
-		processInput(dt);
+		{
+			TRACE_SCOPE("processInput", "input");
+			processInput(dt);
+		}
+
+		// resolve accumulated camera changes once per frame, before the programs cull and refine in update
+		if (cameraChanged) {
+			updateCameraMatrices();
+			writeCamera(projection * view, cam.cameraPos);
+			cameraChanged = false;
+		}
 
 		// update
-		transitionPath->update(dt);
-		for (Program* program : programs) {
-			re_render |= program->update(dt);
+		{
+			TRACE_SCOPE("Transition::update", "update");
+			transitionPath->update(dt);
 		}
+		re_render |= ProgramTimer::updateAll(dt);
 
 		// rendering
 		if (re_render) {
 			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			// render programs
-			for (Program* program : programs) {
-				program->render();
+			// queue draws from all programs, then submit sorted by state
+			for (ProgramTimer& timer : ProgramTimer::timers) {
+				timer.render(drawQueue);
 			}
+			drawQueue.flush();
 
 			// move rendered buffer to screen
+			TRACE_SCOPE("glfwSwapBuffers", "render");
 			glfwSwapBuffers(window);
+			GLStats::endFrame();
 
 			re_render = false;
 		}
+
+		// schedule the next frame
+		scheduleFrame();
 	}
 
 	// cleanup programs
-	for (Program* program : programs) {
-		program->cleanup();
-	}
+	cleanupScene();
 
-	programs.clear();
+	// write trace
+	Tracer::stop();
 
 	// terminate
 	glfwTerminate();
@@ -240,38 +205,61 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
 	glViewport(0, 0, width, height);
 	scr_width = width;
 	scr_height = height;
-	updateCameraMatrices();
+	writeViewport(width, height);
+	cameraMoved();
 }
 
 void processInput(double dt) {
 	if (Keyboard::key(GLFW_KEY_W)) {
 		cam.updateCameraPos(CameraDirection::FORWARD, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 	if (Keyboard::key(GLFW_KEY_S)) {
 		cam.updateCameraPos(CameraDirection::BACKWARD, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 	if (Keyboard::key(GLFW_KEY_D)) {
 		cam.updateCameraPos(CameraDirection::RIGHT, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 	if (Keyboard::key(GLFW_KEY_A)) {
 		cam.updateCameraPos(CameraDirection::LEFT, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 	if (Keyboard::key(GLFW_KEY_SPACE)) {
 		cam.updateCameraPos(CameraDirection::UP, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 	if (Keyboard::key(GLFW_KEY_LEFT_SHIFT)) {
 		cam.updateCameraPos(CameraDirection::DOWN, dt);
-		updateCameraMatrices();
+		cameraMoved();
 	}
 
 	Keyboard::clearKeysChanged();
 }
 
+// request the next wake from held keys, transitions and programs
+void scheduleFrame() {
+	// held movement keys are polled every frame
+	for (int key : movementKeys) {
+		if (Keyboard::key(key)) {
+			FrameScheduler::wakeNow();
+			return;
+		}
+	}
+
+	FrameScheduler::wakeIn(transitionPath->nextChange());
+	for (Program* program : programs) {
+		FrameScheduler::wakeIn(program->nextUpdate());
+	}
+}
+
+// flag camera change, matrices are rebuilt once before the next update
+void cameraMoved() {
+	re_render = true;
+	cameraChanged = true;
+}
+
 void updateCameraMatrices() {
 	view = cam.getViewMatrix();
 	projection = glm::perspective(
@@ -279,12 +267,6 @@ void updateCameraMatrices() {
 		(float)scr_width / (float)scr_height,	// aspect ratio
 		0.1f, 100.0f							// near/far bounds
 	);
-
-	re_render = true;
-
-	for (Program* program : programs) {
-		program->updateCameraMatrices(projection * view, cam.cameraPos);
-	}
 }
 
 void keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -296,6 +278,14 @@ void keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods)
 		transitionPath->toggleRunning();
 	}
 
+	if (key == GLFW_KEY_P && Keyboard::keyWentDown(key)) {
+		ProgramTimer::print(std::cout);
+	}
+
+	if (key == GLFW_KEY_G && Keyboard::keyWentDown(key)) {
+		GLStats::printSummary = !GLStats::printSummary;
+	}
+
 	for (Program* program : programs) {
 		re_render |= program->keyChanged(window, key, scancode, action, mods);
 	}
@@ -307,10 +297,9 @@ void cursorChanged(GLFWwindow* window, double _x, double _y) {
 	double dy = Mouse::getDY();
 	if (dx != 0 || dy != 0) {
 		cam.updateCameraDirection(dx, dy);
+		cameraMoved();
 	}
 
-	updateCameraMatrices();
-
 	for (Program* program : programs) {
 		re_render |= program->cursorChanged(window, _x, _y);
 	}
@@ -327,10 +316,9 @@ void scrollChanged(GLFWwindow* window, double dx, double dy) {
 	double scrollDy = Mouse::getScrollDY();
 	if (scrollDy != 0) {
 		cam.updateCameraZoom(scrollDy);
+		cameraMoved();
 	}
 
-	updateCameraMatrices();
-
 	for (Program* program : programs) {
 		re_render |= program->scrollChanged(window, dx, dy);
 	}
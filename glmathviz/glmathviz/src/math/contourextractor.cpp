@@ -0,0 +1,219 @@
+#include "contourextractor.h"
+
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+
+// end of a closed polyline
+#define CONTOUR_NO_KEY 0xFFFFFFFFFFFFFFFFULL
+
+void ContourExtractor::clear() {
+    vertices.clear();
+    lines.clear();
+}
+
+void ContourExtractor::extract(const float* heights, glm::vec4 bounds, int x_cells, int z_cells,
+    const std::vector<float>& levels, ThreadPool& pool) {
+    if (levels.empty() || x_cells <= 0 || z_cells <= 0) {
+        return;
+    }
+
+    // levels in ascending order, so each cell only visits the levels within its range
+    std::vector<unsigned int> order(levels.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&levels](unsigned int a, unsigned int b) {
+        return levels[a] < levels[b];
+    });
+    std::vector<float> sorted(levels.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        sorted[i] = levels[order[i]];
+    }
+
+    int rowLength = z_cells + 1;
+    float x_inc = (bounds.z - bounds.x) / (float)x_cells;
+    float z_inc = (bounds.w - bounds.y) / (float)z_cells;
+    // key of a grid edge: two edges (along x, along z) per vertex, per level
+    unsigned long long noEdgeKeys = 2ULL * (x_cells + 1) * rowLength;
+
+    unsigned int noBands = (x_cells + CONTOUR_BAND_ROWS - 1) / CONTOUR_BAND_ROWS;
+    std::vector<std::vector<Piece>> bands(noBands);
+    pool.parallelFor(noBands, [&](unsigned int band) {
+        std::vector<Piece> segments;
+        int iEnd = std::min(x_cells, (int)(band + 1) * CONTOUR_BAND_ROWS);
+        for (int i = band * CONTOUR_BAND_ROWS; i < iEnd; i++) {
+            for (int j = 0; j < z_cells; j++) {
+                // corners counterclockwise from (i, j), edges from corner k to k + 1
+                const glm::ivec2 corners[4] = { { i, j }, { i + 1, j }, { i + 1, j + 1 }, { i, j + 1 } };
+                float h[4];
+                float lo = INFINITY;
+                float hi = -INFINITY;
+                bool finite = true;
+                for (int k = 0; k < 4; k++) {
+                    h[k] = heights[corners[k].x * rowLength + corners[k].y];
+                    finite &= isfinite(h[k]) != 0;
+                    lo = std::min(lo, h[k]);
+                    hi = std::max(hi, h[k]);
+                }
+                if (!finite) {
+                    continue;
+                }
+
+                // a level crosses the cell if some corners are above it and some are not
+                for (unsigned int l = (unsigned int)(std::lower_bound(sorted.begin(), sorted.end(), lo) - sorted.begin());
+                    l < sorted.size() && sorted[l] < hi; l++) {
+                    float level = sorted[l];
+                    bool above[4];
+                    for (int k = 0; k < 4; k++) {
+                        above[k] = h[k] > level;
+                    }
+
+                    // crossing point and key of every cut edge
+                    glm::vec3 points[4];
+                    unsigned long long keys[4];
+                    int cut[4];
+                    int noCut = 0;
+                    for (int k = 0; k < 4; k++) {
+                        if (above[k] == above[(k + 1) % 4]) {
+                            continue;
+                        }
+
+                        // interpolate from the lower grid vertex, so neighbouring cells compute the same point
+                        int a = k < 2 ? k : (k + 1) % 4;
+                        int b = k < 2 ? k + 1 : k;
+                        float t = (level - h[a]) / (h[b] - h[a]);
+                        glm::vec2 pa(bounds.x + corners[a].x * x_inc, bounds.y + corners[a].y * z_inc);
+                        glm::vec2 pb(bounds.x + corners[b].x * x_inc, bounds.y + corners[b].y * z_inc);
+                        glm::vec2 p = pa + t * (pb - pa);
+
+                        points[k] = glm::vec3(p.x, level, p.y);
+                        keys[k] = order[l] * noEdgeKeys
+                            + 2ULL * (corners[a].x * rowLength + corners[a].y) + (corners[a].x == corners[b].x ? 1 : 0);
+                        cut[noCut++] = k;
+                    }
+
+                    int pairs[2][2] = { { cut[0], cut[1] }, { -1, -1 } };
+                    if (noCut == 4) {
+                        // saddle, the center decides which opposite corners are connected
+                        bool centerAbove = (h[0] + h[1] + h[2] + h[3]) * 0.25f > level;
+                        if (centerAbove == above[0]) {
+                            // cut off corners 1 and 3
+                            pairs[0][0] = 0; pairs[0][1] = 1;
+                            pairs[1][0] = 2; pairs[1][1] = 3;
+                        }
+                        else {
+                            // cut off corners 0 and 2
+                            pairs[0][0] = 3; pairs[0][1] = 0;
+                            pairs[1][0] = 1; pairs[1][1] = 2;
+                        }
+                    }
+
+                    for (int s = 0; s < 2 && pairs[s][0] >= 0; s++) {
+                        Piece segment;
+                        segment.vertices.push_back(points[pairs[s][0]]);
+                        segment.vertices.push_back(points[pairs[s][1]]);
+                        segment.startKey = keys[pairs[s][0]];
+                        segment.endKey = keys[pairs[s][1]];
+                        segment.level = order[l];
+                        segments.push_back(segment);
+                    }
+                }
+            }
+        }
+
+        bands[band] = chain(segments);
+    });
+
+    // join the lines cut by the band borders
+    std::vector<Piece> pieces;
+    for (std::vector<Piece>& band : bands) {
+        for (Piece& piece : band) {
+            pieces.push_back(std::move(piece));
+        }
+    }
+    std::vector<Piece> joined = chain(pieces);
+
+    for (Piece& line : joined) {
+        lines.push_back({ (unsigned int)vertices.size(), (unsigned int)line.vertices.size(), line.level });
+        vertices.insert(vertices.end(), line.vertices.begin(), line.vertices.end());
+    }
+}
+
+std::vector<ContourExtractor::Piece> ContourExtractor::chain(std::vector<Piece>& pieces) {
+    // end 2 * piece + e (0 = start, 1 = end) to the end of the piece sharing its key
+    std::vector<int> partner(2 * pieces.size(), -1);
+    std::unordered_map<unsigned long long, int> open;
+    for (unsigned int p = 0; p < pieces.size(); p++) {
+        for (int e = 0; e < 2; e++) {
+            unsigned long long key = e ? pieces[p].endKey : pieces[p].startKey;
+            if (key == CONTOUR_NO_KEY) {
+                continue;
+            }
+
+            std::unordered_map<unsigned long long, int>::iterator it = open.find(key);
+            if (it == open.end()) {
+                open[key] = 2 * p + e;
+            }
+            else {
+                partner[it->second] = 2 * p + e;
+                partner[2 * p + e] = it->second;
+                open.erase(it);
+            }
+        }
+    }
+
+    std::vector<Piece> ret;
+    std::vector<bool> visited(pieces.size(), false);
+
+    // follow the pieces from end e of piece p
+    auto walk = [&](unsigned int p, int e) {
+        Piece line;
+        line.level = pieces[p].level;
+        line.startKey = e ? pieces[p].endKey : pieces[p].startKey;
+        line.endKey = CONTOUR_NO_KEY;
+
+        while (true) {
+            visited[p] = true;
+
+            // consecutive pieces share their joining vertex
+            std::vector<glm::vec3>& v = pieces[p].vertices;
+            unsigned int skip = line.vertices.empty() ? 0 : 1;
+            if (e == 0) {
+                line.vertices.insert(line.vertices.end(), v.begin() + skip, v.end());
+            }
+            else {
+                line.vertices.insert(line.vertices.end(), v.rbegin() + skip, v.rend());
+            }
+
+            int next = partner[2 * p + 1 - e];
+            if (next < 0) {
+                line.endKey = e ? pieces[p].startKey : pieces[p].endKey;
+                break;
+            }
+            if (visited[next / 2]) {
+                // back at the start, the last vertex closes the loop
+                line.startKey = CONTOUR_NO_KEY;
+                break;
+            }
+            p = next / 2;
+            e = next % 2;
+        }
+
+        ret.push_back(std::move(line));
+    };
+
+    // open lines from one of their free ends, then the remaining loops
+    for (unsigned int p = 0; p < pieces.size(); p++) {
+        if (!visited[p] && (partner[2 * p] < 0 || partner[2 * p + 1] < 0)) {
+            walk(p, partner[2 * p] < 0 ? 0 : 1);
+        }
+    }
+    for (unsigned int p = 0; p < pieces.size(); p++) {
+        if (!visited[p]) {
+            walk(p, 0);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,53 @@
+#ifndef CONTOUREXTRACTOR_H
+#define CONTOUREXTRACTOR_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "../util/threadpool.h"
+
+// rows of cells per band, the unit of work on the thread pool
+#define CONTOUR_BAND_ROWS 64
+
+typedef struct {
+    unsigned int first; // into vertices
+    unsigned int count;
+    unsigned int level; // index into the levels
+} ContourLine;
+
+/*
+    marching squares contours of a height grid
+    - bands of rows are extracted in parallel and chained into polylines
+    - polylines cut by the band borders are joined in a final serial pass
+    - saddle cells are resolved by the average of their corners
+*/
+
+class ContourExtractor {
+public:
+    // polylines of every extraction since the last clear (closed lines repeat their first vertex)
+    std::vector<glm::vec3> vertices;
+    std::vector<ContourLine> lines;
+
+    // remove all lines
+    void clear();
+
+    // append the contours at levels of heights[x * (z_cells + 1) + z] over bounds (x0, z0, x1, z1)
+    // - vertices are at (x, level, z)
+    void extract(const float* heights, glm::vec4 bounds, int x_cells, int z_cells,
+        const std::vector<float>& levels, ThreadPool& pool);
+
+private:
+    // polyline whose ends lie on the grid edges startKey and endKey (no key if closed)
+    typedef struct {
+        std::vector<glm::vec3> vertices;
+        unsigned long long startKey;
+        unsigned long long endKey;
+        unsigned int level;
+    } Piece;
+
+    // join pieces sharing end keys into the longest possible polylines
+    static std::vector<Piece> chain(std::vector<Piece>& pieces);
+};
+
+#endif
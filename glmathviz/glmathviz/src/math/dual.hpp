@@ -0,0 +1,135 @@
+#ifndef DUAL_HPP
+#define DUAL_HPP
+
+#include <math.h>
+#include <limits>
+#include <type_traits>
+
+/*
+    forward mode automatic differentiation
+    - a Dual carries a value and its derivative, every operation applies the chain rule to both
+    - D is the type of the derivative: T for one direction, a glm vector for a gradient
+    - nest (Dual<Dual<double>>) for second derivatives
+    - works as the component type of glm vectors (glm::tvec3<Dual<double>>)
+*/
+
+template <typename T, typename D = T>
+class Dual {
+public:
+    T val;
+    D der;
+
+    Dual()
+        : val(0), der(0) {}
+
+    // constant (derivative 0), implicit so numbers mix in expressions
+    template <typename S, typename = typename std::enable_if<std::is_arithmetic<S>::value>::type>
+    Dual(S val)
+        : val(static_cast<T>(val)), der(0) {}
+
+    Dual(const T& val, const D& der)
+        : val(val), der(der) {}
+
+    // independent variable with derivative seed (1 for one direction, a unit vector for a gradient)
+    static Dual variable(const T& val, const D& seed = D(1)) {
+        return Dual(val, seed);
+    }
+
+    /*
+        arithmetic
+    */
+
+    friend Dual operator+(const Dual& a, const Dual& b) {
+        return Dual(a.val + b.val, a.der + b.der);
+    }
+
+    friend Dual operator-(const Dual& a, const Dual& b) {
+        return Dual(a.val - b.val, a.der - b.der);
+    }
+
+    friend Dual operator*(const Dual& a, const Dual& b) {
+        return Dual(a.val * b.val, a.der * b.val + b.der * a.val);
+    }
+
+    friend Dual operator/(const Dual& a, const Dual& b) {
+        T inv = T(1) / b.val;
+        return Dual(a.val * inv, (a.der - b.der * (a.val * inv)) * inv);
+    }
+
+    friend Dual operator-(const Dual& a) {
+        return Dual(-a.val, -a.der);
+    }
+
+    friend Dual operator+(const Dual& a) {
+        return a;
+    }
+
+    Dual& operator+=(const Dual& b) { return *this = *this + b; }
+    Dual& operator-=(const Dual& b) { return *this = *this - b; }
+    Dual& operator*=(const Dual& b) { return *this = *this * b; }
+    Dual& operator/=(const Dual& b) { return *this = *this / b; }
+
+    // comparisons only look at the values
+    friend bool operator==(const Dual& a, const Dual& b) { return a.val == b.val; }
+    friend bool operator!=(const Dual& a, const Dual& b) { return a.val != b.val; }
+    friend bool operator<(const Dual& a, const Dual& b) { return a.val < b.val; }
+    friend bool operator>(const Dual& a, const Dual& b) { return a.val > b.val; }
+    friend bool operator<=(const Dual& a, const Dual& b) { return a.val <= b.val; }
+    friend bool operator>=(const Dual& a, const Dual& b) { return a.val >= b.val; }
+
+    /*
+        functions (found by argument dependent lookup next to the ones in math.h)
+    */
+
+    friend Dual sin(const Dual& a) { return Dual(sin(a.val), a.der * cos(a.val)); }
+    friend Dual cos(const Dual& a) { return Dual(cos(a.val), a.der * -sin(a.val)); }
+    friend Dual tan(const Dual& a) {
+        T t = tan(a.val);
+        return Dual(t, a.der * (T(1) + t * t));
+    }
+    friend Dual asin(const Dual& a) { return Dual(asin(a.val), a.der * (T(1) / sqrt(T(1) - a.val * a.val))); }
+    friend Dual acos(const Dual& a) { return Dual(acos(a.val), a.der * (T(-1) / sqrt(T(1) - a.val * a.val))); }
+    friend Dual atan(const Dual& a) { return Dual(atan(a.val), a.der * (T(1) / (T(1) + a.val * a.val))); }
+    friend Dual sinh(const Dual& a) { return Dual(sinh(a.val), a.der * cosh(a.val)); }
+    friend Dual cosh(const Dual& a) { return Dual(cosh(a.val), a.der * sinh(a.val)); }
+    friend Dual tanh(const Dual& a) {
+        T t = tanh(a.val);
+        return Dual(t, a.der * (T(1) - t * t));
+    }
+    friend Dual exp(const Dual& a) {
+        T e = exp(a.val);
+        return Dual(e, a.der * e);
+    }
+    friend Dual log(const Dual& a) { return Dual(log(a.val), a.der * (T(1) / a.val)); }
+    friend Dual sqrt(const Dual& a) {
+        T s = sqrt(a.val);
+        return Dual(s, a.der * (T(0.5) / s));
+    }
+
+    // derivative of |a| is sign(a), 0 at the kink
+    friend Dual fabs(const Dual& a) { return a.val < T(0) ? -a : (a.val > T(0) ? a : Dual(a.val, D(0))); }
+    friend Dual abs(const Dual& a) { return fabs(a); }
+
+    // piecewise constant
+    friend Dual floor(const Dual& a) { return Dual(floor(a.val), D(0)); }
+    friend Dual ceil(const Dual& a) { return Dual(ceil(a.val), D(0)); }
+    friend Dual round(const Dual& a) { return Dual(round(a.val), D(0)); }
+
+    friend Dual pow(const Dual& a, const Dual& b) {
+        T p = pow(a.val, b.val);
+        // d(a^b) = a^b (b' ln(a) + b a' / a), the ln term only where it is defined (positive base)
+        D der = a.der * (b.val * pow(a.val, b.val - T(1)));
+        if (a.val > T(0)) {
+            der = der + b.der * (p * log(a.val));
+        }
+        return Dual(p, der);
+    }
+};
+
+namespace std {
+    // same limits as the value type, glm checks is_iec559 before geometric functions
+    template <typename T, typename D>
+    class numeric_limits<Dual<T, D>> : public numeric_limits<T> {};
+}
+
+#endif
@@ -0,0 +1,735 @@
+#include "expression.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+/*
+    function table
+*/
+
+typedef struct {
+    const char* name;
+    ExprFunc func;
+} FuncName;
+
+const FuncName funcNames[] = {
+    { "sin", ExprFunc::SIN }, { "cos", ExprFunc::COS }, { "tan", ExprFunc::TAN },
+    { "asin", ExprFunc::ASIN }, { "acos", ExprFunc::ACOS }, { "atan", ExprFunc::ATAN },
+    { "sinh", ExprFunc::SINH }, { "cosh", ExprFunc::COSH }, { "tanh", ExprFunc::TANH },
+    { "exp", ExprFunc::EXP }, { "log", ExprFunc::LOG }, { "sqrt", ExprFunc::SQRT },
+    { "abs", ExprFunc::ABS }, { "sign", ExprFunc::SIGN }, { "floor", ExprFunc::FLOOR },
+    { "ceil", ExprFunc::CEIL }, { "round", ExprFunc::ROUND }
+};
+
+const char* funcName(ExprFunc func) {
+    for (const FuncName& entry : funcNames) {
+        if (entry.func == func) {
+            return entry.name;
+        }
+    }
+    return "";
+}
+
+/*
+    construction
+*/
+
+Expression::Expression(ExprType type)
+    : type(type), value(0.0), variable(0), func(ExprFunc::SIN) {}
+
+ExprPtr Expression::constant(double value) {
+    std::shared_ptr<Expression> ret = std::make_shared<Expression>(ExprType::CONSTANT);
+    ret->value = value;
+    return ret;
+}
+
+ExprPtr Expression::var(char variable) {
+    std::shared_ptr<Expression> ret = std::make_shared<Expression>(ExprType::VARIABLE);
+    ret->variable = variable;
+    return ret;
+}
+
+ExprPtr newNode(ExprType type, ExprPtr a, ExprPtr b = nullptr) {
+    std::shared_ptr<Expression> ret = std::make_shared<Expression>(type);
+    ret->a = a;
+    ret->b = b;
+    return ret;
+}
+
+bool isConstantNode(const ExprPtr& e) {
+    return e->type == ExprType::CONSTANT;
+}
+
+ExprPtr Expression::add(ExprPtr a, ExprPtr b) {
+    if (isConstantNode(a) && isConstantNode(b)) {
+        return constant(a->value + b->value);
+    }
+    if (a->isConstant(0.0)) {
+        return b;
+    }
+    if (b->isConstant(0.0)) {
+        return a;
+    }
+    if (b->type == ExprType::NEG) {
+        return sub(a, b->a);
+    }
+    if (a->equals(*b)) {
+        return mul(constant(2.0), a);
+    }
+
+    return newNode(ExprType::ADD, a, b);
+}
+
+ExprPtr Expression::sub(ExprPtr a, ExprPtr b) {
+    if (isConstantNode(a) && isConstantNode(b)) {
+        return constant(a->value - b->value);
+    }
+    if (b->isConstant(0.0)) {
+        return a;
+    }
+    if (a->isConstant(0.0)) {
+        return neg(b);
+    }
+    if (b->type == ExprType::NEG) {
+        return add(a, b->a);
+    }
+    if (a->equals(*b)) {
+        return constant(0.0);
+    }
+
+    return newNode(ExprType::SUB, a, b);
+}
+
+ExprPtr Expression::mul(ExprPtr a, ExprPtr b) {
+    if (isConstantNode(a) && isConstantNode(b)) {
+        return constant(a->value * b->value);
+    }
+    if (a->isConstant(0.0) || b->isConstant(0.0)) {
+        return constant(0.0);
+    }
+    if (a->isConstant(1.0)) {
+        return b;
+    }
+    if (b->isConstant(1.0)) {
+        return a;
+    }
+    if (a->isConstant(-1.0)) {
+        return neg(b);
+    }
+    if (b->isConstant(-1.0)) {
+        return neg(a);
+    }
+    if (a->type == ExprType::NEG) {
+        return neg(mul(a->a, b));
+    }
+    if (b->type == ExprType::NEG) {
+        return neg(mul(a, b->a));
+    }
+    if (isConstantNode(b)) {
+        // constants first
+        return mul(b, a);
+    }
+
+    return newNode(ExprType::MUL, a, b);
+}
+
+ExprPtr Expression::div(ExprPtr a, ExprPtr b) {
+    if (isConstantNode(a) && isConstantNode(b) && b->value != 0.0) {
+        return constant(a->value / b->value);
+    }
+    if (a->isConstant(0.0)) {
+        return constant(0.0);
+    }
+    if (b->isConstant(1.0)) {
+        return a;
+    }
+    if (a->type == ExprType::NEG) {
+        return neg(div(a->a, b));
+    }
+    if (b->type == ExprType::NEG) {
+        return neg(div(a, b->a));
+    }
+
+    return newNode(ExprType::DIV, a, b);
+}
+
+ExprPtr Expression::pow(ExprPtr a, ExprPtr b) {
+    if (isConstantNode(a) && isConstantNode(b)) {
+        return constant(::pow(a->value, b->value));
+    }
+    if (b->isConstant(0.0)) {
+        return constant(1.0);
+    }
+    if (b->isConstant(1.0)) {
+        return a;
+    }
+
+    return newNode(ExprType::POW, a, b);
+}
+
+ExprPtr Expression::neg(ExprPtr a) {
+    if (isConstantNode(a)) {
+        return constant(a->value != 0.0 ? -a->value : 0.0);
+    }
+    if (a->type == ExprType::NEG) {
+        return a->a;
+    }
+
+    return newNode(ExprType::NEG, a);
+}
+
+ExprPtr Expression::call(ExprFunc func, ExprPtr a) {
+    std::shared_ptr<Expression> ret = std::make_shared<Expression>(ExprType::FUNCTION);
+    ret->func = func;
+    ret->a = a;
+
+    if (isConstantNode(a)) {
+        return constant(ret->evaluate(0.0, 0.0, 0.0));
+    }
+
+    return ret;
+}
+
+/*
+    parsing (recursive descent)
+    expr    := term (('+' | '-') term)*
+    term    := unary (('*' | '/') unary)*
+    unary   := ('-' | '+') unary | power
+    power   := primary ('^' unary)?
+    primary := number | variable | constant | func '(' expr ')' | 'pow' '(' expr ',' expr ')' | '(' expr ')'
+*/
+
+class Parser {
+public:
+    Parser(const std::string& src, const char* variables)
+        : src(src), variables(variables), cursor(0) {}
+
+    ExprPtr parse(std::string& error) {
+        ExprPtr ret = parseExpr();
+        skipSpace();
+        if (ret && cursor < src.size()) {
+            fail("unexpected '" + std::string(1, src[cursor]) + "'");
+        }
+
+        if (!this->error.empty()) {
+            error = this->error + " at position " + std::to_string(errorPos);
+            return nullptr;
+        }
+        return ret;
+    }
+
+private:
+    const std::string& src;
+    const char* variables;
+    size_t cursor;
+    std::string error;
+    size_t errorPos;
+
+    ExprPtr fail(const std::string& message) {
+        if (error.empty()) {
+            error = message;
+            errorPos = cursor;
+        }
+        return nullptr;
+    }
+
+    void skipSpace() {
+        while (cursor < src.size() && isspace((unsigned char)src[cursor])) {
+            cursor++;
+        }
+    }
+
+    bool accept(char c) {
+        skipSpace();
+        if (cursor < src.size() && src[cursor] == c) {
+            cursor++;
+            return true;
+        }
+        return false;
+    }
+
+    ExprPtr parseExpr() {
+        ExprPtr ret = parseTerm();
+        while (ret) {
+            if (accept('+')) {
+                ExprPtr rhs = parseTerm();
+                ret = rhs ? Expression::add(ret, rhs) : nullptr;
+            }
+            else if (accept('-')) {
+                ExprPtr rhs = parseTerm();
+                ret = rhs ? Expression::sub(ret, rhs) : nullptr;
+            }
+            else {
+                break;
+            }
+        }
+        return ret;
+    }
+
+    ExprPtr parseTerm() {
+        ExprPtr ret = parseUnary();
+        while (ret) {
+            if (accept('*')) {
+                ExprPtr rhs = parseUnary();
+                ret = rhs ? Expression::mul(ret, rhs) : nullptr;
+            }
+            else if (accept('/')) {
+                ExprPtr rhs = parseUnary();
+                ret = rhs ? Expression::div(ret, rhs) : nullptr;
+            }
+            else {
+                break;
+            }
+        }
+        return ret;
+    }
+
+    ExprPtr parseUnary() {
+        if (accept('-')) {
+            ExprPtr operand = parseUnary();
+            return operand ? Expression::neg(operand) : nullptr;
+        }
+        if (accept('+')) {
+            return parseUnary();
+        }
+        return parsePower();
+    }
+
+    ExprPtr parsePower() {
+        ExprPtr ret = parsePrimary();
+        if (ret && accept('^')) {
+            ExprPtr exponent = parseUnary();
+            ret = exponent ? Expression::pow(ret, exponent) : nullptr;
+        }
+        return ret;
+    }
+
+    ExprPtr parsePrimary() {
+        skipSpace();
+        if (cursor >= src.size()) {
+            return fail("unexpected end of expression");
+        }
+
+        if (accept('(')) {
+            ExprPtr ret = parseExpr();
+            if (ret && !accept(')')) {
+                return fail("expected ')'");
+            }
+            return ret;
+        }
+
+        char c = src[cursor];
+        if (isdigit((unsigned char)c) || c == '.') {
+            const char* start = src.c_str() + cursor;
+            char* end = nullptr;
+            double value = strtod(start, &end);
+            if (end == start) {
+                return fail("invalid number");
+            }
+            cursor += end - start;
+            return Expression::constant(value);
+        }
+
+        if (isalpha((unsigned char)c)) {
+            size_t start = cursor;
+            while (cursor < src.size() && isalnum((unsigned char)src[cursor])) {
+                cursor++;
+            }
+            std::string name = src.substr(start, cursor - start);
+
+            if (name.size() == 1 && strchr(variables, name[0])) {
+                return Expression::var(name[0]);
+            }
+            if (name == "pi") {
+                return Expression::constant(3.14159265358979323846);
+            }
+            if (name == "e") {
+                return Expression::constant(2.71828182845904523536);
+            }
+            if (name == "pow") {
+                if (!accept('(')) {
+                    return fail("expected '(' after pow");
+                }
+                ExprPtr base = parseExpr();
+                if (!base || !accept(',')) {
+                    return fail("expected ',' in pow");
+                }
+                ExprPtr exponent = parseExpr();
+                if (!exponent || !accept(')')) {
+                    return fail("expected ')'");
+                }
+                return Expression::pow(base, exponent);
+            }
+            for (const FuncName& entry : funcNames) {
+                if (name == entry.name) {
+                    if (!accept('(')) {
+                        return fail("expected '(' after " + name);
+                    }
+                    ExprPtr arg = parseExpr();
+                    if (!arg || !accept(')')) {
+                        return fail("expected ')'");
+                    }
+                    return Expression::call(entry.func, arg);
+                }
+            }
+
+            cursor = start;
+            return fail("unknown identifier '" + name + "'");
+        }
+
+        return fail("unexpected '" + std::string(1, c) + "'");
+    }
+};
+
+ExprPtr Expression::parse(const std::string& src, std::string& error, const char* variables) {
+    Parser parser(src, variables);
+    return parser.parse(error);
+}
+
+/*
+    operations
+*/
+
+ExprPtr Expression::derivative(char variable) const {
+    switch (type) {
+    case ExprType::CONSTANT:
+        return constant(0.0);
+    case ExprType::VARIABLE:
+        return constant(this->variable == variable ? 1.0 : 0.0);
+    case ExprType::ADD:
+        return add(a->derivative(variable), b->derivative(variable));
+    case ExprType::SUB:
+        return sub(a->derivative(variable), b->derivative(variable));
+    case ExprType::MUL:
+        // product rule
+        return add(mul(a->derivative(variable), b), mul(a, b->derivative(variable)));
+    case ExprType::DIV:
+        // quotient rule
+        return div(
+            sub(mul(a->derivative(variable), b), mul(a, b->derivative(variable))),
+            mul(b, b));
+    case ExprType::POW:
+        if (!b->dependsOn(variable)) {
+            // power rule
+            return mul(mul(b, pow(a, sub(b, constant(1.0)))), a->derivative(variable));
+        }
+        // d(a^b) = a^b * (b' ln(a) + b a' / a)
+        return mul(pow(a, b), add(
+            mul(b->derivative(variable), call(ExprFunc::LOG, a)),
+            div(mul(b, a->derivative(variable)), a)));
+    case ExprType::NEG:
+        return neg(a->derivative(variable));
+    case ExprType::FUNCTION:
+        break;
+    }
+
+    // chain rule
+    ExprPtr inner = a->derivative(variable);
+    if (inner->isConstant(0.0)) {
+        return inner;
+    }
+
+    ExprPtr outer;
+    switch (func) {
+    case ExprFunc::SIN: outer = call(ExprFunc::COS, a); break;
+    case ExprFunc::COS: outer = neg(call(ExprFunc::SIN, a)); break;
+    case ExprFunc::TAN: outer = div(constant(1.0), pow(call(ExprFunc::COS, a), constant(2.0))); break;
+    case ExprFunc::ASIN: outer = div(constant(1.0), call(ExprFunc::SQRT, sub(constant(1.0), pow(a, constant(2.0))))); break;
+    case ExprFunc::ACOS: outer = neg(div(constant(1.0), call(ExprFunc::SQRT, sub(constant(1.0), pow(a, constant(2.0)))))); break;
+    case ExprFunc::ATAN: outer = div(constant(1.0), add(constant(1.0), pow(a, constant(2.0)))); break;
+    case ExprFunc::SINH: outer = call(ExprFunc::COSH, a); break;
+    case ExprFunc::COSH: outer = call(ExprFunc::SINH, a); break;
+    case ExprFunc::TANH: outer = sub(constant(1.0), pow(call(ExprFunc::TANH, a), constant(2.0))); break;
+    case ExprFunc::EXP: outer = call(ExprFunc::EXP, a); break;
+    case ExprFunc::LOG: outer = div(constant(1.0), a); break;
+    case ExprFunc::SQRT: outer = div(constant(0.5), call(ExprFunc::SQRT, a)); break;
+    case ExprFunc::ABS: outer = call(ExprFunc::SIGN, a); break;
+    default:
+        // piecewise constant (sign, floor, ceil, round)
+        return constant(0.0);
+    }
+
+    return mul(outer, inner);
+}
+
+/*
+    evaluation over double or Dual values (one walk gives the value and the derivatives)
+*/
+
+template <typename V>
+V evaluateT(const Expression& e, const V& x, const V& y, const V& z, const V& t) {
+    switch (e.type) {
+    case ExprType::CONSTANT: return V(e.value);
+    case ExprType::VARIABLE: return e.variable == 't' ? t : (e.variable == 'x' || e.variable == 'u' ? x : (e.variable == 'y' ? y : z));
+    case ExprType::ADD: return evaluateT(*e.a, x, y, z, t) + evaluateT(*e.b, x, y, z, t);
+    case ExprType::SUB: return evaluateT(*e.a, x, y, z, t) - evaluateT(*e.b, x, y, z, t);
+    case ExprType::MUL: return evaluateT(*e.a, x, y, z, t) * evaluateT(*e.b, x, y, z, t);
+    case ExprType::DIV: return evaluateT(*e.a, x, y, z, t) / evaluateT(*e.b, x, y, z, t);
+    case ExprType::POW: return pow(evaluateT(*e.a, x, y, z, t), evaluateT(*e.b, x, y, z, t));
+    case ExprType::NEG: return -evaluateT(*e.a, x, y, z, t);
+    case ExprType::FUNCTION: break;
+    }
+
+    V arg = evaluateT(*e.a, x, y, z, t);
+    switch (e.func) {
+    case ExprFunc::SIN: return sin(arg);
+    case ExprFunc::COS: return cos(arg);
+    case ExprFunc::TAN: return tan(arg);
+    case ExprFunc::ASIN: return asin(arg);
+    case ExprFunc::ACOS: return acos(arg);
+    case ExprFunc::ATAN: return atan(arg);
+    case ExprFunc::SINH: return sinh(arg);
+    case ExprFunc::COSH: return cosh(arg);
+    case ExprFunc::TANH: return tanh(arg);
+    case ExprFunc::EXP: return exp(arg);
+    case ExprFunc::LOG: return log(arg);
+    case ExprFunc::SQRT: return sqrt(arg);
+    case ExprFunc::ABS: return fabs(arg);
+    case ExprFunc::SIGN: return V((double)((arg > 0.0) - (arg < 0.0)));
+    case ExprFunc::FLOOR: return floor(arg);
+    case ExprFunc::CEIL: return ceil(arg);
+    case ExprFunc::ROUND: return round(arg);
+    }
+
+    return V(0.0);
+}
+
+template <typename V>
+void evaluateBatchT(const Expression& e, const V* x, const V* y, const V* z, const V& t, V* out) {
+    V rhs[EXPR_BATCH];
+
+    switch (e.type) {
+    case ExprType::CONSTANT:
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] = e.value;
+        return;
+    case ExprType::VARIABLE:
+        if (e.variable == 't') {
+            for (int i = 0; i < EXPR_BATCH; i++) out[i] = t;
+        }
+        else {
+            const V* src = e.variable == 'x' || e.variable == 'u' ? x : (e.variable == 'y' ? y : z);
+            for (int i = 0; i < EXPR_BATCH; i++) out[i] = src[i];
+        }
+        return;
+    case ExprType::ADD:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        evaluateBatchT(*e.b, x, y, z, t, rhs);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] += rhs[i];
+        return;
+    case ExprType::SUB:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        evaluateBatchT(*e.b, x, y, z, t, rhs);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] -= rhs[i];
+        return;
+    case ExprType::MUL:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        evaluateBatchT(*e.b, x, y, z, t, rhs);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] *= rhs[i];
+        return;
+    case ExprType::DIV:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        evaluateBatchT(*e.b, x, y, z, t, rhs);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] /= rhs[i];
+        return;
+    case ExprType::POW:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        if (e.b->isConstant(2.0)) {
+            for (int i = 0; i < EXPR_BATCH; i++) out[i] *= out[i];
+            return;
+        }
+        evaluateBatchT(*e.b, x, y, z, t, rhs);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] = pow(out[i], rhs[i]);
+        return;
+    case ExprType::NEG:
+        evaluateBatchT(*e.a, x, y, z, t, out);
+        for (int i = 0; i < EXPR_BATCH; i++) out[i] = -out[i];
+        return;
+    case ExprType::FUNCTION:
+        break;
+    }
+
+    evaluateBatchT(*e.a, x, y, z, t, out);
+    switch (e.func) {
+    case ExprFunc::SIN: for (int i = 0; i < EXPR_BATCH; i++) out[i] = sin(out[i]); break;
+    case ExprFunc::COS: for (int i = 0; i < EXPR_BATCH; i++) out[i] = cos(out[i]); break;
+    case ExprFunc::TAN: for (int i = 0; i < EXPR_BATCH; i++) out[i] = tan(out[i]); break;
+    case ExprFunc::ASIN: for (int i = 0; i < EXPR_BATCH; i++) out[i] = asin(out[i]); break;
+    case ExprFunc::ACOS: for (int i = 0; i < EXPR_BATCH; i++) out[i] = acos(out[i]); break;
+    case ExprFunc::ATAN: for (int i = 0; i < EXPR_BATCH; i++) out[i] = atan(out[i]); break;
+    case ExprFunc::SINH: for (int i = 0; i < EXPR_BATCH; i++) out[i] = sinh(out[i]); break;
+    case ExprFunc::COSH: for (int i = 0; i < EXPR_BATCH; i++) out[i] = cosh(out[i]); break;
+    case ExprFunc::TANH: for (int i = 0; i < EXPR_BATCH; i++) out[i] = tanh(out[i]); break;
+    case ExprFunc::EXP: for (int i = 0; i < EXPR_BATCH; i++) out[i] = exp(out[i]); break;
+    case ExprFunc::LOG: for (int i = 0; i < EXPR_BATCH; i++) out[i] = log(out[i]); break;
+    case ExprFunc::SQRT: for (int i = 0; i < EXPR_BATCH; i++) out[i] = sqrt(out[i]); break;
+    case ExprFunc::ABS: for (int i = 0; i < EXPR_BATCH; i++) out[i] = fabs(out[i]); break;
+    case ExprFunc::SIGN: for (int i = 0; i < EXPR_BATCH; i++) out[i] = (double)((out[i] > 0.0) - (out[i] < 0.0)); break;
+    case ExprFunc::FLOOR: for (int i = 0; i < EXPR_BATCH; i++) out[i] = floor(out[i]); break;
+    case ExprFunc::CEIL: for (int i = 0; i < EXPR_BATCH; i++) out[i] = ceil(out[i]); break;
+    case ExprFunc::ROUND: for (int i = 0; i < EXPR_BATCH; i++) out[i] = round(out[i]); break;
+    }
+}
+
+double Expression::evaluate(double x, double z, double t) const {
+    return evaluate(x, 0.0, z, t);
+}
+
+double Expression::evaluate(double x, double y, double z, double t) const {
+    return evaluateT<double>(*this, x, y, z, t);
+}
+
+ExprDual3 Expression::evaluate(const ExprDual3& x, const ExprDual3& y, const ExprDual3& z, double t) const {
+    return evaluateT<ExprDual3>(*this, x, y, z, t);
+}
+
+void Expression::evaluateBatch(const double* x, const double* z, double t, double* out) const {
+    evaluateBatch(x, nullptr, z, t, out);
+}
+
+void Expression::evaluateBatch(const double* x, const double* y, const double* z, double t, double* out) const {
+    evaluateBatchT<double>(*this, x, y, z, t, out);
+}
+
+void Expression::evaluateBatch(const ExprDual2* x, const ExprDual2* z, double t, ExprDual2* out) const {
+    evaluateBatchT<ExprDual2>(*this, x, nullptr, z, t, out);
+}
+
+// float literal GLSL accepts
+// - folded constants may be infinite or undefined (1/0, log(0)), GLSL has no literal for those
+std::string glslFloat(double value) {
+    if (isnan(value)) {
+        return "(0.0 / 0.0)";
+    }
+    if (isinf(value)) {
+        return value > 0.0 ? "(1.0 / 0.0)" : "(-1.0 / 0.0)";
+    }
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+
+    std::string ret = buf;
+    if (ret.find_first_of(".eE") == std::string::npos) {
+        ret += ".0";
+    }
+    return value < 0.0 ? "(" + ret + ")" : ret;
+}
+
+std::string Expression::toGLSL() const {
+    switch (type) {
+    case ExprType::CONSTANT:
+        return glslFloat(value);
+    case ExprType::VARIABLE:
+        return variable == 't' ? "time" : std::string(1, variable);
+    case ExprType::ADD:
+        return "(" + a->toGLSL() + " + " + b->toGLSL() + ")";
+    case ExprType::SUB:
+        return "(" + a->toGLSL() + " - " + b->toGLSL() + ")";
+    case ExprType::MUL:
+        return "(" + a->toGLSL() + " * " + b->toGLSL() + ")";
+    case ExprType::DIV:
+        return "(" + a->toGLSL() + " / " + b->toGLSL() + ")";
+    case ExprType::POW:
+        if (b->isConstant(2.0)) {
+            std::string base = a->toGLSL();
+            return "(" + base + " * " + base + ")";
+        }
+        if (isConstantNode(b) && b->value == floor(b->value)) {
+            // GLSL pow is undefined for negative bases
+            return "powi(" + a->toGLSL() + ", " + b->toGLSL() + ")";
+        }
+        return "pow(" + a->toGLSL() + ", " + b->toGLSL() + ")";
+    case ExprType::NEG:
+        return "(-" + a->toGLSL() + ")";
+    case ExprType::FUNCTION:
+        break;
+    }
+
+    return std::string(funcName(func)) + "(" + a->toGLSL() + ")";
+}
+
+std::string Expression::glslPrelude() {
+    // integer powers of negative bases (GLSL pow is undefined for them)
+    return "float powi(float b, float e) {\n"
+        "    return (b < 0.0 && mod(e, 2.0) == 1.0) ? -pow(-b, e) : pow(abs(b), e);\n"
+        "}\n";
+}
+
+std::string Expression::toComplexGLSL() const {
+    switch (type) {
+    case ExprType::CONSTANT: {
+        // high and low float parts (no low part past the float range)
+        double hi = (double)(float)value;
+        double lo = isfinite(hi) ? value - hi : 0.0;
+        return "cconst(" + glslFloat(hi) + ", " + glslFloat(lo) + ")";
+    }
+    case ExprType::VARIABLE:
+        if (variable == 'i') {
+            return "cimag()";
+        }
+        return variable == 't' ? "cconst(time, 0.0)" : std::string(1, variable);
+    case ExprType::ADD:
+        return "cadd(" + a->toComplexGLSL() + ", " + b->toComplexGLSL() + ")";
+    case ExprType::SUB:
+        return "csub(" + a->toComplexGLSL() + ", " + b->toComplexGLSL() + ")";
+    case ExprType::MUL:
+        return "cmul(" + a->toComplexGLSL() + ", " + b->toComplexGLSL() + ")";
+    case ExprType::DIV:
+        return "cdiv(" + a->toComplexGLSL() + ", " + b->toComplexGLSL() + ")";
+    case ExprType::POW:
+        if (isConstantNode(b) && b->value == floor(b->value) && fabs(b->value) <= 1024.0) {
+            // repeated squaring, exact for the double-float layer
+            return "cpowi(" + a->toComplexGLSL() + ", " + std::to_string((int)b->value) + ")";
+        }
+        return "cpow(" + a->toComplexGLSL() + ", " + b->toComplexGLSL() + ")";
+    case ExprType::NEG:
+        return "cneg(" + a->toComplexGLSL() + ")";
+    case ExprType::FUNCTION:
+        break;
+    }
+
+    return "c" + std::string(funcName(func)) + "(" + a->toComplexGLSL() + ")";
+}
+
+bool Expression::dependsOn(char variable) const {
+    if (type == ExprType::VARIABLE) {
+        return this->variable == variable;
+    }
+
+    return (a && a->dependsOn(variable)) || (b && b->dependsOn(variable));
+}
+
+bool Expression::equals(const Expression& other) const {
+    if (type != other.type) {
+        return false;
+    }
+
+    switch (type) {
+    case ExprType::CONSTANT: return value == other.value;
+    case ExprType::VARIABLE: return variable == other.variable;
+    case ExprType::FUNCTION:
+        if (func != other.func) {
+            return false;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return (!a || a->equals(*other.a)) && (!b || b->equals(*other.b));
+}
+
+bool Expression::isConstant(double value) const {
+    return type == ExprType::CONSTANT && this->value == value;
+}
+
+unsigned long long Expression::hash(const std::string& str) {
+    unsigned long long ret = 14695981039346656037ULL;
+    for (char c : str) {
+        ret ^= (unsigned char)c;
+        ret *= 1099511628211ULL;
+    }
+    return ret;
+}
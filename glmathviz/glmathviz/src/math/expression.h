@@ -0,0 +1,121 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+
+#include "dual.hpp"
+
+// points per batch evaluation (two AVX2 or four NEON vectors of doubles)
+#define EXPR_BATCH 8
+
+/*
+    symbolic expression in the variables x, y, z and t (u and v for parametric surfaces)
+    - parsed from strings like "3 * sin(x) / (1 + z^2)"
+    - supports symbolic differentiation, evaluation and GLSL emission
+*/
+
+class Expression;
+typedef std::shared_ptr<const Expression> ExprPtr;
+
+// value with its derivatives along the seeds of the variables (see Dual)
+typedef Dual<double, glm::dvec2> ExprDual2; // (d/dx, d/dz) of a surface
+typedef Dual<double, glm::dvec3> ExprDual3; // (d/dx, d/dy, d/dz) of an implicit function
+
+enum class ExprType {
+    CONSTANT,
+    VARIABLE,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    POW,
+    NEG,
+    FUNCTION
+};
+
+enum class ExprFunc {
+    SIN, COS, TAN,
+    ASIN, ACOS, ATAN,
+    SINH, COSH, TANH,
+    EXP, LOG, SQRT,
+    ABS, SIGN, FLOOR, CEIL, ROUND
+};
+
+class Expression {
+public:
+    ExprType type;
+    double value;   // CONSTANT
+    char variable;  // VARIABLE ('x' or 'u', 'y', 'z' or 'v', 't', 'i' in complex expressions)
+    ExprFunc func;  // FUNCTION
+    ExprPtr a;      // operand (unary) or left operand
+    ExprPtr b;      // right operand
+
+    /*
+        construction (simplifies constant and identity cases)
+    */
+
+    static ExprPtr constant(double value);
+    static ExprPtr var(char variable);
+    static ExprPtr add(ExprPtr a, ExprPtr b);
+    static ExprPtr sub(ExprPtr a, ExprPtr b);
+    static ExprPtr mul(ExprPtr a, ExprPtr b);
+    static ExprPtr div(ExprPtr a, ExprPtr b);
+    static ExprPtr pow(ExprPtr a, ExprPtr b);
+    static ExprPtr neg(ExprPtr a);
+    static ExprPtr call(ExprFunc func, ExprPtr a);
+
+    // parse source, returns null and sets error on failure
+    // - variables lists the accepted names ("uvt" for parametric surfaces, "xyzt" for implicit surfaces, "zit" for complex functions)
+    static ExprPtr parse(const std::string& src, std::string& error, const char* variables = "xzt");
+
+    /*
+        operations
+    */
+
+    // derivative with respect to variable
+    ExprPtr derivative(char variable) const;
+
+    // evaluate at a point (x is also u, z is also v)
+    double evaluate(double x, double z, double t) const;
+    double evaluate(double x, double y, double z, double t) const;
+
+    // value and derivatives in the same walk (forward mode), the seeds of x, y and z choose the directions
+    ExprDual3 evaluate(const ExprDual3& x, const ExprDual3& y, const ExprDual3& z, double t) const;
+
+    // evaluate at EXPR_BATCH points, walking the tree once per batch
+    // - each node runs a fixed-width loop over the batch, which the compiler vectorizes
+    // - y may be null if the expression does not depend on it
+    void evaluateBatch(const double* x, const double* z, double t, double* out) const;
+    void evaluateBatch(const double* x, const double* y, const double* z, double t, double* out) const;
+    void evaluateBatch(const ExprDual2* x, const ExprDual2* z, double t, ExprDual2* out) const;
+
+    // GLSL source (t is emitted as the uniform "time")
+    std::string toGLSL() const;
+
+    // GLSL helpers called by toGLSL output, emit once before the generated functions
+    static std::string glslPrelude();
+
+    // GLSL source over complex values of type C (see complex.glsl), z is the argument and i the imaginary unit
+    // - constants are emitted as float pairs, so the double-float layer keeps their full precision
+    // - constant subexpressions are folded over the reals when constructed (write i, not sqrt(-1))
+    std::string toComplexGLSL() const;
+
+    // if the variable appears in the expression
+    bool dependsOn(char variable) const;
+
+    // structural equality
+    bool equals(const Expression& other) const;
+
+    // if the expression is the constant value
+    bool isConstant(double value) const;
+
+    // 64 bit FNV-1a hash of a string (used to key generated shaders)
+    static unsigned long long hash(const std::string& str);
+
+    Expression(ExprType type);
+};
+
+#endif
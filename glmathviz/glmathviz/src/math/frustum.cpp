@@ -0,0 +1,52 @@
+#include "frustum.h"
+
+#include <math.h>
+
+/*
+    constructor
+*/
+
+Frustum::Frustum() {
+    for (int i = 0; i < 6; i++) {
+        planes[i] = glm::vec4(0.0f);
+    }
+}
+
+Frustum::Frustum(glm::mat4 projView) {
+    // rows of the matrix (glm is column major)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(projView[0][i], projView[1][i], projView[2][i], projView[3][i]);
+    }
+
+    // -w <= x, y, z <= w
+    for (int i = 0; i < 3; i++) {
+        planes[2 * i] = rows[3] + rows[i];
+        planes[2 * i + 1] = rows[3] - rows[i];
+    }
+}
+
+/*
+    tests
+*/
+
+bool Frustum::intersects(glm::vec3 min, glm::vec3 max) const {
+    if (!isfinite(min.y) || !isfinite(max.y)) {
+        // unbounded box
+        return true;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        // corner farthest along the plane normal
+        glm::vec3 corner(
+            planes[i].x >= 0.0f ? max.x : min.x,
+            planes[i].y >= 0.0f ? max.y : min.y,
+            planes[i].z >= 0.0f ? max.z : min.z
+        );
+        if (glm::dot(glm::vec3(planes[i]), corner) + planes[i].w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
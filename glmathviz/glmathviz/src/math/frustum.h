@@ -0,0 +1,33 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/*
+    view frustum as six planes, for culling bounding boxes on the CPU
+    - default constructed frustum contains everything
+*/
+
+class Frustum {
+public:
+    // planes (normal, distance), inside where dot(normal, p) + distance >= 0
+    glm::vec4 planes[6];
+
+    /*
+        constructor
+    */
+
+    Frustum();
+
+    // extract the planes from the combined projection * view matrix
+    Frustum(glm::mat4 projView);
+
+    /*
+        tests
+    */
+
+    // if any part of the box may be visible (conservative)
+    bool intersects(glm::vec3 min, glm::vec3 max) const;
+};
+
+#endif
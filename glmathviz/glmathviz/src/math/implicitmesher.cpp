@@ -0,0 +1,387 @@
+#include "implicitmesher.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+/*
+    marching cubes tables
+    - corner c is at (c & 1, (c >> 1) & 1, (c >> 2) & 1), a corner is inside where f < 0
+    - edge e runs along axis e / 4 from edgeCorners[e][0] to edgeCorners[e][1]
+*/
+
+typedef struct McTables {
+    int edgeCorners[12][2];
+    // edge triples of the triangles of each configuration (bit c set = corner c inside), terminated by -1
+    signed char triangles[256][16];
+
+    McTables() {
+        int edgeIndex[8][8];
+        int noEdges = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            for (int c = 0; c < 8; c++) {
+                if (!(c & (1 << axis))) {
+                    edgeCorners[noEdges][0] = c;
+                    edgeCorners[noEdges][1] = c | (1 << axis);
+                    edgeIndex[c][c | (1 << axis)] = edgeIndex[c | (1 << axis)][c] = noEdges;
+                    noEdges++;
+                }
+            }
+        }
+
+        // corners of each face, counterclockwise seen from outside the cube
+        const int faces[6][4] = {
+            { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+            { 0, 1, 5, 4 }, { 2, 6, 7, 3 },
+            { 0, 2, 3, 1 }, { 4, 5, 7, 6 }
+        };
+
+        for (int config = 0; config < 256; config++) {
+            // on each face, the contour runs from the edge entering the inside corners to the edge leaving them
+            // - each cut edge is entered on one face and left on the other, so the segments close into loops
+            // - ambiguous faces keep the inside corners apart, which neighbouring cubes agree on
+            int next[12];
+            for (int e = 0; e < 12; e++) {
+                next[e] = -1;
+            }
+            for (int f = 0; f < 6; f++) {
+                int cuts[4];
+                bool entering[4];
+                int noCuts = 0;
+                for (int k = 0; k < 4; k++) {
+                    int c0 = faces[f][k];
+                    int c1 = faces[f][(k + 1) % 4];
+                    bool in0 = (config >> c0) & 1;
+                    bool in1 = (config >> c1) & 1;
+                    if (in0 != in1) {
+                        cuts[noCuts] = edgeIndex[c0][c1];
+                        entering[noCuts++] = in1;
+                    }
+                }
+                for (int k = 0; k < noCuts; k++) {
+                    if (entering[k]) {
+                        next[cuts[k]] = cuts[(k + 1) % noCuts];
+                    }
+                }
+            }
+
+            // fan triangulate each loop
+            int noIndices = 0;
+            bool visited[12] = { false };
+            for (int e = 0; e < 12; e++) {
+                if (next[e] < 0 || visited[e]) {
+                    continue;
+                }
+
+                visited[e] = true;
+                for (int a = next[e], b = next[a]; b != e; a = b, b = next[b]) {
+                    visited[a] = visited[b] = true;
+                    triangles[config][noIndices++] = (signed char)e;
+                    triangles[config][noIndices++] = (signed char)a;
+                    triangles[config][noIndices++] = (signed char)b;
+                }
+            }
+            triangles[config][noIndices] = -1;
+        }
+    }
+} McTables;
+
+const McTables& mcTables() {
+    static McTables tables;
+    return tables;
+}
+
+// floor(a / b) for b > 0
+int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/*
+    constructor
+*/
+
+ImplicitMesher::ImplicitMesher(int brickCells, unsigned int maxCachedBricks)
+    : brickCells(brickCells), maxCachedBricks(maxCachedBricks),
+    noBricks(0), noMeshed(0), noSkipped(0), t(0.0), generation(0) {}
+
+/*
+    state
+*/
+
+void ImplicitMesher::setExpression(ExprPtr expression) {
+    f = expression;
+    cache.clear();
+    lastKeys.clear();
+}
+
+void ImplicitMesher::setTime(double t) {
+    if (t != this->t && f && f->dependsOn('t')) {
+        cache.clear();
+        lastKeys.clear();
+    }
+    this->t = t;
+}
+
+/*
+    meshing
+*/
+
+bool ImplicitMesher::BrickKey::operator<(const BrickKey& other) const {
+    if (cellSize != other.cellSize) {
+        return cellSize < other.cellSize;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (start[i] != other.start[i]) {
+            return start[i] < other.start[i];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (end[i] != other.end[i]) {
+            return end[i] < other.end[i];
+        }
+    }
+    return false;
+}
+
+bool ImplicitMesher::build(glm::vec3 min, glm::vec3 max, float cellSize, ThreadPool& pool) {
+    generation++;
+
+    // cells covering the box, then the bricks covering the cells
+    glm::ivec3 cellStart(glm::floor(min / cellSize));
+    glm::ivec3 cellEnd(glm::ceil(max / cellSize));
+    std::vector<BrickKey> keys;
+    if (cellEnd.x > cellStart.x && cellEnd.y > cellStart.y && cellEnd.z > cellStart.z) {
+        glm::ivec3 first(floorDiv(cellStart.x, brickCells), floorDiv(cellStart.y, brickCells), floorDiv(cellStart.z, brickCells));
+        glm::ivec3 last(floorDiv(cellEnd.x - 1, brickCells), floorDiv(cellEnd.y - 1, brickCells), floorDiv(cellEnd.z - 1, brickCells));
+        for (int i = first.x; i <= last.x; i++) {
+            for (int j = first.y; j <= last.y; j++) {
+                for (int k = first.z; k <= last.z; k++) {
+                    glm::ivec3 brick(i, j, k);
+                    BrickKey key = {
+                        glm::max(brick * brickCells, cellStart),
+                        glm::min((brick + 1) * brickCells, cellEnd),
+                        cellSize
+                    };
+                    keys.push_back(key);
+                }
+            }
+        }
+    }
+
+    // polygonize the bricks not in the cache
+    std::vector<std::pair<const BrickKey*, Brick*>> missing;
+    std::vector<Brick*> bricks(keys.size());
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        std::map<BrickKey, Brick>::iterator it = cache.find(keys[i]);
+        if (it == cache.end()) {
+            it = cache.insert(std::make_pair(keys[i], Brick())).first;
+            missing.push_back(std::make_pair(&it->first, &it->second));
+        }
+        it->second.lastUsed = generation;
+        bricks[i] = &it->second;
+    }
+
+    std::atomic<unsigned int> skipped(0);
+    pool.parallelFor((unsigned int)missing.size(), [this, &missing, &skipped](unsigned int i) {
+        if (mayContainZero(*missing[i].first)) {
+            polygonize(*missing[i].first, missing[i].second->vertices);
+        }
+        else {
+            skipped++;
+        }
+    });
+    noBricks = (unsigned int)keys.size();
+    noMeshed = (unsigned int)missing.size() - skipped;
+    noSkipped = skipped;
+
+    bool changed = !missing.empty() || keys.size() != lastKeys.size();
+    for (unsigned int i = 0; i < keys.size() && !changed; i++) {
+        changed = keys[i] < lastKeys[i] || lastKeys[i] < keys[i];
+    }
+
+    if (changed) {
+        // concatenate the bricks
+        std::vector<size_t> offsets(bricks.size() + 1, 0);
+        for (unsigned int i = 0; i < bricks.size(); i++) {
+            offsets[i + 1] = offsets[i] + bricks[i]->vertices.size();
+        }
+        vertices.resize(offsets.back());
+        pool.parallelFor((unsigned int)bricks.size(), [this, &bricks, &offsets](unsigned int i) {
+            if (!bricks[i]->vertices.empty()) {
+                memcpy(&vertices[offsets[i]], &bricks[i]->vertices[0], bricks[i]->vertices.size() * sizeof(ImplicitVertex));
+            }
+        });
+        lastKeys = keys;
+    }
+
+    evict();
+    return changed;
+}
+
+bool ImplicitMesher::mayContainZero(const BrickKey& key) {
+    double x[EXPR_BATCH];
+    double y[EXPR_BATCH];
+    double z[EXPR_BATCH];
+    double val[EXPR_BATCH];
+    double prev[IMPLICIT_RANGE_SAMPLES][IMPLICIT_RANGE_SAMPLES][IMPLICIT_RANGE_SAMPLES];
+
+    int samples = IMPLICIT_RANGE_SAMPLES < EXPR_BATCH ? IMPLICIT_RANGE_SAMPLES : EXPR_BATCH;
+    glm::dvec3 start = glm::dvec3(key.start) * (double)key.cellSize;
+    glm::dvec3 inc = glm::dvec3(key.end - key.start) * (double)key.cellSize / (double)(samples - 1);
+    for (int k = 0; k < EXPR_BATCH; k++) {
+        z[k] = start.z + (k < samples ? k : samples - 1) * inc.z;
+    }
+
+    double fMin = INFINITY;
+    double fMax = -INFINITY;
+    double step = 0.0;
+    for (int i = 0; i < samples; i++) {
+        for (int j = 0; j < samples; j++) {
+            for (int k = 0; k < EXPR_BATCH; k++) {
+                x[k] = start.x + i * inc.x;
+                y[k] = start.y + j * inc.y;
+            }
+            f->evaluateBatch(x, y, z, t, val);
+
+            for (int k = 0; k < samples; k++) {
+                if (!isfinite(val[k])) {
+                    return true;
+                }
+                fMin = val[k] < fMin ? val[k] : fMin;
+                fMax = val[k] > fMax ? val[k] : fMax;
+                if (k) {
+                    step = fmax(step, fabs(val[k] - val[k - 1]));
+                }
+                if (j) {
+                    step = fmax(step, fabs(val[k] - prev[i][j - 1][k]));
+                }
+                if (i) {
+                    step = fmax(step, fabs(val[k] - prev[i - 1][j][k]));
+                }
+                prev[i][j][k] = val[k];
+            }
+        }
+    }
+
+    return fMin - step <= 0.0 && fMax + step >= 0.0;
+}
+
+void ImplicitMesher::polygonize(const BrickKey& key, std::vector<ImplicitVertex>& out) {
+    const McTables& tables = mcTables();
+    glm::ivec3 n = key.end - key.start;
+    glm::ivec3 stride((n.y + 1) * (n.z + 1), n.z + 1, 1);
+    double cellSize = (double)key.cellSize;
+
+    // samples at the cell corners, one z row per batch
+    std::vector<double> samples((n.x + 1) * stride.x);
+    double x[EXPR_BATCH];
+    double y[EXPR_BATCH];
+    double z[EXPR_BATCH];
+    double val[EXPR_BATCH];
+    for (int i = 0; i <= n.x; i++) {
+        for (int j = 0; j <= n.y; j++) {
+            for (int k = 0; k < EXPR_BATCH; k++) {
+                x[k] = (key.start.x + i) * cellSize;
+                y[k] = (key.start.y + j) * cellSize;
+            }
+
+            double* row = &samples[i * stride.x + j * stride.y];
+            for (int k0 = 0; k0 <= n.z; k0 += EXPR_BATCH) {
+                int count = n.z + 1 - k0 < EXPR_BATCH ? n.z + 1 - k0 : EXPR_BATCH;
+                for (int k = 0; k < EXPR_BATCH; k++) {
+                    // pad the last batch by repeating the final point
+                    z[k] = (key.start.z + k0 + (k < count ? k : count - 1)) * cellSize;
+                }
+                f->evaluateBatch(x, y, z, t, val);
+                memcpy(row + k0, val, count * sizeof(double));
+            }
+        }
+    }
+
+    // vertex on each cut lattice edge, computed once and shared by the cells around it
+    std::vector<ImplicitVertex> edgeVertices;
+    std::vector<int> edgeVertex[3];
+    for (int axis = 0; axis < 3; axis++) {
+        edgeVertex[axis].assign(samples.size(), -1);
+    }
+
+    for (int i = 0; i < n.x; i++) {
+        for (int j = 0; j < n.y; j++) {
+            for (int k = 0; k < n.z; k++) {
+                int base = i * stride.x + j * stride.y + k;
+                int config = 0;
+                for (int c = 0; c < 8; c++) {
+                    int idx = base + (c & 1) * stride.x + ((c >> 1) & 1) * stride.y + ((c >> 2) & 1);
+                    config |= (samples[idx] < 0.0) << c;
+                }
+
+                const signed char* triangles = tables.triangles[config];
+                for (int v = 0; triangles[v] >= 0; v += 3) {
+                    ImplicitVertex triangle[3];
+                    for (int corner = 0; corner < 3; corner++) {
+                        int e = triangles[v + corner];
+                        int c0 = tables.edgeCorners[e][0];
+                        int axis = e / 4;
+                        glm::ivec3 p0(i + (c0 & 1), j + ((c0 >> 1) & 1), k + ((c0 >> 2) & 1));
+                        int idx0 = p0.x * stride.x + p0.y * stride.y + p0.z;
+
+                        int& vertex = edgeVertex[axis][idx0];
+                        if (vertex < 0) {
+                            // interpolate the crossing, normal from the gradient (one forward mode evaluation)
+                            double f0 = samples[idx0];
+                            double f1 = samples[idx0 + stride[axis]];
+                            glm::dvec3 pos = glm::dvec3(key.start + p0) * cellSize;
+                            double s = f0 / (f0 - f1);
+                            pos[axis] += cellSize * (s >= 0.0 && s <= 1.0 ? s : 0.5);
+
+                            glm::dvec3 grad = f->evaluate(
+                                ExprDual3::variable(pos.x, glm::dvec3(1.0, 0.0, 0.0)),
+                                ExprDual3::variable(pos.y, glm::dvec3(0.0, 1.0, 0.0)),
+                                ExprDual3::variable(pos.z, glm::dvec3(0.0, 0.0, 1.0)), t).der;
+                            double len = glm::length(grad);
+
+                            vertex = (int)edgeVertices.size();
+                            edgeVertices.push_back({ glm::vec3(pos),
+                                len > 0.0 && isfinite(len) ? glm::vec3(grad / len) : glm::vec3(0.0f) });
+                        }
+                        triangle[corner] = edgeVertices[vertex];
+                    }
+
+                    // face normal where the gradient vanishes
+                    glm::vec3 faceNormal = glm::cross(triangle[1].pos - triangle[0].pos, triangle[2].pos - triangle[0].pos);
+                    for (int corner = 0; corner < 3; corner++) {
+                        if (triangle[corner].normal == glm::vec3(0.0f)) {
+                            triangle[corner].normal = faceNormal;
+                        }
+                        out.push_back(triangle[corner]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ImplicitMesher::evict() {
+    if (cache.size() <= maxCachedBricks) {
+        return;
+    }
+
+    // oldest first, bricks of the last build are never dropped
+    std::vector<std::pair<unsigned long long, std::map<BrickKey, Brick>::iterator>> entries;
+    for (std::map<BrickKey, Brick>::iterator it = cache.begin(); it != cache.end(); it++) {
+        if (it->second.lastUsed != generation) {
+            entries.push_back(std::make_pair(it->second.lastUsed, it));
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const std::pair<unsigned long long, std::map<BrickKey, Brick>::iterator>& a,
+            const std::pair<unsigned long long, std::map<BrickKey, Brick>::iterator>& b) {
+            return a.first < b.first;
+        });
+
+    for (unsigned int i = 0; i < entries.size() && cache.size() > maxCachedBricks; i++) {
+        cache.erase(entries[i].second);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef IMPLICITMESHER_H
+#define IMPLICITMESHER_H
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <vector>
+
+#include "expression.h"
+#include "../util/threadpool.h"
+
+// cells per side of a brick
+#define IMPLICIT_BRICK_CELLS 16
+// samples per side for the range of a brick
+#define IMPLICIT_RANGE_SAMPLES 5
+
+typedef struct {
+    glm::vec3 pos;
+    glm::vec3 normal;
+} ImplicitVertex;
+
+/*
+    marching cubes polygonizer for implicit surfaces f(x, y, z, t) = 0
+    - the box is split into bricks of brickCells^3 cells on a lattice anchored at the origin
+    - bricks are meshed in parallel, those whose sampled range excludes zero are skipped
+    - meshed bricks are cached by lattice position and cell size, so pans and resolution
+      changes only polygonize the bricks that were not meshed before
+*/
+
+class ImplicitMesher {
+public:
+    // cells per brick side
+    int brickCells;
+    // bricks kept in the cache, least recently used ones are dropped first
+    unsigned int maxCachedBricks;
+
+    // triangles of the last build (3 vertices each), ordered by brick
+    std::vector<ImplicitVertex> vertices;
+
+    // bricks in the last build, and how many of them were polygonized or skipped by their range
+    unsigned int noBricks;
+    unsigned int noMeshed;
+    unsigned int noSkipped;
+
+    /*
+        constructor
+    */
+
+    ImplicitMesher(int brickCells = IMPLICIT_BRICK_CELLS, unsigned int maxCachedBricks = 4096);
+
+    /*
+        state
+    */
+
+    // function f(x, y, z, t), clears the cache
+    void setExpression(ExprPtr expression);
+
+    // time of the function, clears the cache if the function depends on it
+    void setTime(double t);
+
+    /*
+        meshing
+    */
+
+    // polygonize f = 0 over the box [min, max] with cubic cells of cellSize
+    // - returns if vertices changed
+    bool build(glm::vec3 min, glm::vec3 max, float cellSize, ThreadPool& pool);
+
+private:
+    ExprPtr f;
+    double t;
+
+    // cells of the brick clipped to the box, in units of cellSize
+    typedef struct BrickKey {
+        glm::ivec3 start;
+        glm::ivec3 end;
+        float cellSize;
+
+        bool operator<(const BrickKey& other) const;
+    } BrickKey;
+
+    typedef struct {
+        std::vector<ImplicitVertex> vertices;
+        unsigned long long lastUsed;
+    } Brick;
+
+    std::map<BrickKey, Brick> cache;
+    std::vector<BrickKey> lastKeys;
+    unsigned long long generation;
+
+    // if the range of f over the brick may contain zero (padded like SurfaceEvaluator::sampleRange)
+    bool mayContainZero(const BrickKey& key);
+
+    // marching cubes over the cells of the brick
+    void polygonize(const BrickKey& key, std::vector<ImplicitVertex>& out);
+
+    // drop least recently used bricks beyond maxCachedBricks
+    void evict();
+};
+
+#endif
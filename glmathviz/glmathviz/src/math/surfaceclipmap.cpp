@@ -0,0 +1,155 @@
+#include "surfaceclipmap.h"
+
+#include <math.h>
+#include <algorithm>
+
+/*
+    constructor
+*/
+
+SurfaceClipmap::SurfaceClipmap(int patchCells, float cellSize)
+    : patchCells(patchCells), cellSize(cellSize), xOffset(0.0), t(0.0), viewPos(0.0f) {}
+
+/*
+    state
+*/
+
+void SurfaceClipmap::setExpression(ExprPtr expression) {
+    this->expression = expression;
+}
+
+void SurfaceClipmap::setFunctionState(double xOffset, double t) {
+    this->xOffset = xOffset;
+    this->t = t;
+}
+
+void SurfaceClipmap::setCamera(glm::vec3 viewPos) {
+    this->viewPos = viewPos;
+}
+
+/*
+    rings
+*/
+
+glm::ivec2 SurfaceClipmap::latticeCells(glm::vec4 bounds) {
+    // round so the lattice ends exactly on the far edges
+    return glm::ivec2(
+        glm::max(1, (int)roundf((bounds.z - bounds.x) / cellSize)),
+        glm::max(1, (int)roundf((bounds.w - bounds.y) / cellSize))
+    );
+}
+
+bool SurfaceClipmap::build(const std::vector<glm::vec4>& bounds) {
+    std::vector<QuadLeaf> prevChunks;
+    prevChunks.swap(chunks);
+
+    for (unsigned int instance = 0; instance < bounds.size(); instance++) {
+        buildInstance(instance, bounds[instance]);
+    }
+
+    if (chunks.size() != prevChunks.size()) {
+        return true;
+    }
+    // bounds follow the instance bounds and cellSize, which keep the indices of a chunk
+    for (unsigned int i = 0; i < chunks.size(); i++) {
+        if (chunks[i].instance != prevChunks[i].instance
+            || chunks[i].bounds != prevChunks[i].bounds
+            || chunks[i].level != prevChunks[i].level
+            || chunks[i].i != prevChunks[i].i
+            || chunks[i].j != prevChunks[i].j
+            || chunks[i].stitch != prevChunks[i].stitch) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// largest multiple of size not above val
+long long snapDown(double val, long long size) {
+    return (long long)floor(val / (double)size) * size;
+}
+
+void SurfaceClipmap::buildInstance(unsigned int instance, glm::vec4 bounds) {
+    glm::ivec2 n = latticeCells(bounds);
+    glm::dvec2 cell(((double)bounds.z - bounds.x) / n.x, ((double)bounds.w - bounds.y) / n.y);
+
+    // camera in lattice coordinates
+    double cx = (viewPos.x - bounds.x) / cell.x;
+    double cz = (viewPos.z - bounds.y) / cell.y;
+
+    // rings much smaller than the camera's height above the surface cover almost no pixels
+    double height = 0.0;
+    if (expression) {
+        height = fabs(viewPos.y - expression->evaluate(viewPos.x - xOffset, viewPos.z, t));
+    }
+    int minLevel = 0;
+    while (minLevel < CLIPMAP_MAX_LEVELS - 1
+        && CLIPMAP_RING_CHUNKS * (double)(patchCells << minLevel) * glm::max(cell.x, cell.y) < height) {
+        minLevel++;
+    }
+
+    // region covered by the previous (finer) level, in lattice units
+    long long inner[4] = { 0, 0, 0, 0 };
+
+    for (int level = minLevel; level < CLIPMAP_MAX_LEVELS; level++) {
+        long long size = (long long)patchCells << level;
+        long long x0 = snapDown(cx, 2 * size) - CLIPMAP_RING_CHUNKS * size;
+        long long z0 = snapDown(cz, 2 * size) - CLIPMAP_RING_CHUNKS * size;
+        long long x1 = x0 + 2 * CLIPMAP_RING_CHUNKS * size;
+        long long z1 = z0 + 2 * CLIPMAP_RING_CHUNKS * size;
+        bool last = level == CLIPMAP_MAX_LEVELS - 1
+            || (x0 <= 0 && z0 <= 0 && x1 >= n.x && z1 >= n.y);
+
+        // whether the next level borders this one on each side (inside the domain)
+        bool coarserX0 = !last && x0 > 0;
+        bool coarserX1 = !last && x1 < n.x;
+        bool coarserZ0 = !last && z0 > 0;
+        bool coarserZ1 = !last && z1 < n.y;
+
+        for (long long a = x0; a < x1; a += size) {
+            if (a >= n.x || a + size <= 0) {
+                continue;
+            }
+            for (long long b = z0; b < z1; b += size) {
+                if (b >= n.y || b + size <= 0) {
+                    continue;
+                }
+                if (level > minLevel && a >= inner[0] && a < inner[2] && b >= inner[1] && b < inner[3]) {
+                    // covered by the finer level
+                    continue;
+                }
+
+                int stitch = 0;
+                if (coarserX0 && a == x0) {
+                    stitch |= QUAD_STITCH_X0;
+                }
+                if (coarserX1 && a + size == x1) {
+                    stitch |= QUAD_STITCH_X1;
+                }
+                if (coarserZ0 && b == z0) {
+                    stitch |= QUAD_STITCH_Z0;
+                }
+                if (coarserZ1 && b + size == z1) {
+                    stitch |= QUAD_STITCH_Z1;
+                }
+
+                // part of the chunk inside the instance
+                glm::vec4 chunkBounds(
+                    (float)(bounds.x + std::max(a, 0LL) * cell.x),
+                    (float)(bounds.y + std::max(b, 0LL) * cell.y),
+                    (float)(bounds.x + std::min(a + size, (long long)n.x) * cell.x),
+                    (float)(bounds.y + std::min(b + size, (long long)n.y) * cell.y)
+                );
+                chunks.push_back({ instance, level, (int)(a / size), (int)(b / size), chunkBounds, stitch });
+            }
+        }
+
+        if (last) {
+            break;
+        }
+        inner[0] = x0;
+        inner[1] = z0;
+        inner[2] = x1;
+        inner[3] = z1;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef SURFACECLIPMAP_H
+#define SURFACECLIPMAP_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "expression.h"
+#include "surfacequadtree.h"
+
+// most rings per instance
+#define CLIPMAP_MAX_LEVELS 16
+// ring half size in chunks of its level (at least 4 keeps every ring one chunk wide)
+#define CLIPMAP_RING_CHUNKS 4
+
+/*
+    nested rings of square chunks centered on the camera's projection onto the xz plane
+    - chunks of level l are patchCells x patchCells cells of cellSize * 2^l
+    - every level is snapped to the lattice of the next one, so rings nest without gaps
+    - the chunks on the outside of a ring are stitched to the coarser ring around them
+    - cost depends on the number of rings (log of the domain size), not on the domain area
+*/
+
+class SurfaceClipmap {
+public:
+    // cells per chunk side
+    int patchCells;
+    // finest cell size (world units)
+    float cellSize;
+
+    // chunks of the last build (QuadLeaf::i, j index chunks of their level), ordered by instance
+    std::vector<QuadLeaf> chunks;
+
+    /*
+        constructor
+    */
+
+    SurfaceClipmap(int patchCells = 8, float cellSize = 0.04f);
+
+    /*
+        state
+    */
+
+    // function y = f(x - xOffset, z, t), used for the camera height above the surface
+    void setExpression(ExprPtr expression);
+    void setFunctionState(double xOffset, double t);
+
+    // camera the rings are centered on
+    void setCamera(glm::vec3 viewPos);
+
+    /*
+        rings
+    */
+
+    // number of finest cells across an instance (x, z)
+    glm::ivec2 latticeCells(glm::vec4 bounds);
+
+    // place the rings for the instances (x0, z0, x1, z1), returns if the chunks changed
+    bool build(const std::vector<glm::vec4>& bounds);
+
+private:
+    ExprPtr expression;
+    double xOffset;
+    double t;
+    glm::vec3 viewPos;
+
+    // add the chunks of one instance
+    void buildInstance(unsigned int instance, glm::vec4 bounds);
+};
+
+#endif
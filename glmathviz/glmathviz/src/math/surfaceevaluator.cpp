@@ -0,0 +1,144 @@
+#include "surfaceevaluator.h"
+
+#include <math.h>
+
+void SurfaceEvaluator::setExpression(ExprPtr expression) {
+    f = expression;
+}
+
+void SurfaceEvaluator::evaluate(glm::vec4 bounds, int x_cells, int z_cells, double xOffset, double t,
+    bool analyticNormals, glm::vec4* out, ThreadPool& pool) {
+    int rowLength = z_cells + 1;
+    double x_inc = ((double)bounds.z - (double)bounds.x) / (double)x_cells;
+    double z_inc = ((double)bounds.w - (double)bounds.y) / (double)z_cells;
+
+    // heights (and analytic normals), one row per job
+    pool.parallelFor(x_cells + 1, [&](unsigned int i) {
+        double x[EXPR_BATCH];
+        double z[EXPR_BATCH];
+        double y[EXPR_BATCH];
+        // x and z seeded with the unit directions, y carries the gradient
+        ExprDual2 xd[EXPR_BATCH];
+        ExprDual2 zd[EXPR_BATCH];
+        ExprDual2 yd[EXPR_BATCH];
+
+        // the function is shifted by x_offset, the vertex is not
+        double rowX = (double)bounds.x + i * x_inc - xOffset;
+        for (int k = 0; k < EXPR_BATCH; k++) {
+            x[k] = rowX;
+            xd[k] = ExprDual2::variable(rowX, glm::dvec2(1.0, 0.0));
+        }
+
+        glm::vec4* row = out + i * rowLength;
+        for (int j = 0; j < rowLength; j += EXPR_BATCH) {
+            int n = rowLength - j < EXPR_BATCH ? rowLength - j : EXPR_BATCH;
+            for (int k = 0; k < EXPR_BATCH; k++) {
+                // pad the last batch by repeating the final point
+                z[k] = (double)bounds.y + (j + (k < n ? k : n - 1)) * z_inc;
+                zd[k] = ExprDual2::variable(z[k], glm::dvec2(0.0, 1.0));
+            }
+
+            if (analyticNormals) {
+                f->evaluateBatch(xd, zd, t, yd);
+                for (int k = 0; k < n; k++) {
+                    row[j + k] = glm::vec4((float)yd[k].val, (float)-yd[k].der.x, (float)-yd[k].der.y, 0.0f);
+                }
+            }
+            else {
+                f->evaluateBatch(x, z, t, y);
+                for (int k = 0; k < n; k++) {
+                    row[j + k] = glm::vec4((float)y[k], 0.0f, 0.0f, 0.0f);
+                }
+            }
+        }
+    });
+
+    if (analyticNormals) {
+        return;
+    }
+
+    // normals from the neighbouring heights (backward at the far edges)
+    pool.parallelFor(x_cells + 1, [&](unsigned int i) {
+        glm::vec4* row = out + i * rowLength;
+        glm::vec4* nextRow = i < (unsigned int)x_cells ? row + rowLength : row;
+        glm::vec4* prevRow = i < (unsigned int)x_cells ? row : row - rowLength;
+
+        for (int j = 0; j < rowLength; j++) {
+            int j0 = j < z_cells ? j : j - 1;
+            row[j].y = -(nextRow[j].x - prevRow[j].x) / (float)x_inc;
+            row[j].z = -(row[j0 + 1].x - row[j0].x) / (float)z_inc;
+        }
+    });
+}
+
+void SurfaceEvaluator::evaluateHeights(glm::vec4 bounds, int x_cells, int z_cells, double xOffset, double t,
+    float* out, ThreadPool& pool) {
+    int rowLength = z_cells + 1;
+    double x_inc = ((double)bounds.z - (double)bounds.x) / (double)x_cells;
+    double z_inc = ((double)bounds.w - (double)bounds.y) / (double)z_cells;
+
+    pool.parallelFor(x_cells + 1, [&](unsigned int i) {
+        double x[EXPR_BATCH];
+        double z[EXPR_BATCH];
+        double y[EXPR_BATCH];
+
+        double rowX = (double)bounds.x + i * x_inc - xOffset;
+        for (int k = 0; k < EXPR_BATCH; k++) {
+            x[k] = rowX;
+        }
+
+        float* row = out + i * rowLength;
+        for (int j = 0; j < rowLength; j += EXPR_BATCH) {
+            int n = rowLength - j < EXPR_BATCH ? rowLength - j : EXPR_BATCH;
+            for (int k = 0; k < EXPR_BATCH; k++) {
+                z[k] = (double)bounds.y + (j + (k < n ? k : n - 1)) * z_inc;
+            }
+
+            f->evaluateBatch(x, z, t, y);
+            for (int k = 0; k < n; k++) {
+                row[j + k] = (float)y[k];
+            }
+        }
+    });
+}
+
+glm::vec2 SurfaceEvaluator::sampleRange(glm::vec4 bounds, int samples, double xOffset, double t) {
+    double x[EXPR_BATCH];
+    double z[EXPR_BATCH];
+    double y[EXPR_BATCH];
+    double prevRow[EXPR_BATCH];
+
+    samples = samples < 2 ? 2 : (samples > EXPR_BATCH ? EXPR_BATCH : samples);
+    double x_inc = ((double)bounds.z - (double)bounds.x) / (samples - 1);
+    double z_inc = ((double)bounds.w - (double)bounds.y) / (samples - 1);
+    for (int k = 0; k < EXPR_BATCH; k++) {
+        z[k] = (double)bounds.y + (k < samples ? k : samples - 1) * z_inc;
+    }
+
+    double yMin = INFINITY;
+    double yMax = -INFINITY;
+    double step = 0.0;
+    for (int i = 0; i < samples; i++) {
+        for (int k = 0; k < EXPR_BATCH; k++) {
+            x[k] = (double)bounds.x + i * x_inc - xOffset;
+        }
+        f->evaluateBatch(x, z, t, y);
+
+        for (int k = 0; k < samples; k++) {
+            if (!isfinite(y[k])) {
+                return glm::vec2(-INFINITY, INFINITY);
+            }
+            yMin = y[k] < yMin ? y[k] : yMin;
+            yMax = y[k] > yMax ? y[k] : yMax;
+            if (k) {
+                step = fmax(step, fabs(y[k] - y[k - 1]));
+            }
+            if (i) {
+                step = fmax(step, fabs(y[k] - prevRow[k]));
+            }
+            prevRow[k] = y[k];
+        }
+    }
+
+    return glm::vec2((float)(yMin - step), (float)(yMax + step));
+}
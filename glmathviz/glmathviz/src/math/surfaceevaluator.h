@@ -0,0 +1,37 @@
+#ifndef SURFACEEVALUATOR_H
+#define SURFACEEVALUATOR_H
+
+#include <glm/glm.hpp>
+
+#include "expression.h"
+#include "../util/threadpool.h"
+
+/*
+    CPU backend for surface functions y = f(x, z, t)
+    - evaluates in double precision, EXPR_BATCH points at a time
+    - rows of the grid are split across the thread pool
+*/
+
+class SurfaceEvaluator {
+public:
+    void setExpression(ExprPtr expression);
+
+    // fill out[x * (z_cells + 1) + z] for the (x_cells + 1) x (z_cells + 1) vertex grid over bounds (x0, z0, x1, z1)
+    // - each vertex is (y, normal.x, normal.z, 0), the normal being (normal.x, 1, normal.z)
+    // - normals are analytic (gradient carried along with the heights, see Dual), or forward differences of the neighbouring heights
+    void evaluate(glm::vec4 bounds, int x_cells, int z_cells, double xOffset, double t,
+        bool analyticNormals, glm::vec4* out, ThreadPool& pool);
+
+    // fill out[x * (z_cells + 1) + z] with the heights only (contours)
+    void evaluateHeights(glm::vec4 bounds, int x_cells, int z_cells, double xOffset, double t,
+        float* out, ThreadPool& pool);
+
+    // range of y over bounds (x0, z0, x1, z1) from samples x samples points (single thread)
+    // - padded by the largest step between neighbouring samples, unbounded if any sample is not finite
+    glm::vec2 sampleRange(glm::vec4 bounds, int samples, double xOffset, double t);
+
+private:
+    ExprPtr f;
+};
+
+#endif
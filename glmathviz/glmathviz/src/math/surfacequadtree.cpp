@@ -0,0 +1,259 @@
+#include "surfacequadtree.h"
+
+#include <math.h>
+
+/*
+    constructor
+*/
+
+SurfaceQuadtree::SurfaceQuadtree(int patchCells, int minDepth, int maxDepth, float maxScreenError)
+    : patchCells(patchCells), minDepth(minDepth), maxDepth(maxDepth), maxScreenError(maxScreenError),
+    xOffset(0.0), t(0.0), projScale(1.0f), viewPos(0.0f) {
+    setMaxDepth(maxDepth);
+}
+
+/*
+    state
+*/
+
+void SurfaceQuadtree::setMaxDepth(int maxDepth) {
+    this->maxDepth = maxDepth;
+    // forced splits past maxDepth would leave nodes collect never reaches
+    minDepth = glm::min(minDepth, maxDepth);
+}
+
+void SurfaceQuadtree::setExpression(ExprPtr expression) {
+    this->expression = expression;
+    cache.clear();
+}
+
+void SurfaceQuadtree::setFunctionState(double xOffset, double t) {
+    if (xOffset != this->xOffset || (t != this->t && expression && expression->dependsOn('t'))) {
+        cache.clear();
+    }
+    this->xOffset = xOffset;
+    this->t = t;
+}
+
+void SurfaceQuadtree::setCamera(glm::mat4 projView, glm::vec3 viewPos) {
+    // the y row of projView is the view space y axis scaled by the projection
+    projScale = glm::length(glm::vec3(projView[0][1], projView[1][1], projView[2][1]));
+    this->viewPos = viewPos;
+}
+
+/*
+    subdivision
+*/
+
+bool SurfaceQuadtree::build(const std::vector<glm::vec4>& bounds) {
+    std::vector<QuadLeaf> prevLeaves;
+    prevLeaves.swap(leaves);
+
+    leafKeys.clear();
+    for (unsigned int instance = 0; instance < bounds.size(); instance++) {
+        refine(instance, bounds[instance], 0, 0, 0);
+        balance(instance);
+        collect(instance, bounds[instance], 0, 0, 0, leaves);
+    }
+
+    if (leaves.size() != prevLeaves.size()) {
+        return true;
+    }
+    for (unsigned int i = 0; i < leaves.size(); i++) {
+        if (leaves[i].instance != prevLeaves[i].instance
+            || leaves[i].bounds != prevLeaves[i].bounds
+            || leaves[i].stitch != prevLeaves[i].stitch) {
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned long long SurfaceQuadtree::key(unsigned int instance, int level, int i, int j) {
+    return ((unsigned long long)instance << 40)
+        | ((unsigned long long)level << 32)
+        | ((unsigned long long)i << 16)
+        | (unsigned long long)j;
+}
+
+glm::vec4 SurfaceQuadtree::nodeBounds(glm::vec4 root, int level, int i, int j) {
+    float size = 1.0f / (float)(1 << level);
+    return glm::vec4(
+        glm::mix(root.x, root.z, i * size),
+        glm::mix(root.y, root.w, j * size),
+        glm::mix(root.x, root.z, (i + 1) * size),
+        glm::mix(root.y, root.w, (j + 1) * size)
+    );
+}
+
+SurfaceQuadtree::NodeEstimate& SurfaceQuadtree::estimate(unsigned int instance, glm::vec4 root, int level, int i, int j) {
+    unsigned long long k = key(instance, level, i, j);
+    std::unordered_map<unsigned long long, NodeEstimate>::iterator it = cache.find(k);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    // 3 x 3 samples over the node
+    glm::vec4 b = nodeBounds(root, level, i, j);
+    double y[3][3];
+    bool finite = true;
+    NodeEstimate ret = { 0.0f, INFINITY, -INFINITY };
+    for (int u = 0; u < 3; u++) {
+        for (int v = 0; v < 3; v++) {
+            double x = glm::mix((double)b.x, (double)b.z, u * 0.5) - xOffset;
+            double z = glm::mix((double)b.y, (double)b.w, v * 0.5);
+            y[u][v] = expression->evaluate(x, z, t);
+
+            if (isfinite(y[u][v])) {
+                ret.yMin = glm::min(ret.yMin, (float)y[u][v]);
+                ret.yMax = glm::max(ret.yMax, (float)y[u][v]);
+            }
+            else {
+                finite = false;
+            }
+        }
+    }
+    if (ret.yMin > ret.yMax) {
+        ret.yMin = ret.yMax = 0.0f;
+    }
+
+    if (!finite) {
+        // poles and gaps are refined as far as allowed
+        ret.error = INFINITY;
+    }
+    else {
+        // deviation of the midpoints from the bilinear patch through the corners
+        double error = 0.0;
+        error = glm::max(error, fabs(y[1][0] - 0.5 * (y[0][0] + y[2][0])));
+        error = glm::max(error, fabs(y[1][2] - 0.5 * (y[0][2] + y[2][2])));
+        error = glm::max(error, fabs(y[0][1] - 0.5 * (y[0][0] + y[0][2])));
+        error = glm::max(error, fabs(y[2][1] - 0.5 * (y[2][0] + y[2][2])));
+        error = glm::max(error, fabs(y[1][1] - 0.25 * (y[0][0] + y[2][0] + y[0][2] + y[2][2])));
+
+        // second order error shrinks with the square of the cell size
+        ret.error = (float)(error / (patchCells * patchCells));
+    }
+
+    return cache[k] = ret;
+}
+
+bool SurfaceQuadtree::shouldSplit(unsigned int instance, glm::vec4 root, int level, int i, int j) {
+    if (level >= maxDepth) {
+        return false;
+    }
+    if (level < minDepth) {
+        return true;
+    }
+
+    NodeEstimate& node = estimate(instance, root, level, i, j);
+
+    // distance to the closest point of the node's bounding box
+    glm::vec4 b = nodeBounds(root, level, i, j);
+    glm::vec3 closest = glm::clamp(viewPos,
+        glm::vec3(b.x, node.yMin, b.y),
+        glm::vec3(b.z, node.yMax, b.w));
+    float distance = glm::max(glm::length(viewPos - closest), 1e-3f);
+
+    return node.error * projScale / distance > maxScreenError;
+}
+
+void SurfaceQuadtree::refine(unsigned int instance, glm::vec4 root, int level, int i, int j) {
+    if (shouldSplit(instance, root, level, i, j)) {
+        for (int c = 0; c < 4; c++) {
+            refine(instance, root, level + 1, 2 * i + (c & 1), 2 * j + (c >> 1));
+        }
+    }
+    else {
+        leafKeys.insert(key(instance, level, i, j));
+    }
+}
+
+int SurfaceQuadtree::coveringLevel(unsigned int instance, int level, int i, int j) {
+    if (i < 0 || j < 0 || i >= (1 << level) || j >= (1 << level)) {
+        return -1;
+    }
+
+    for (int l = level; l >= 0; l--) {
+        if (leafKeys.count(key(instance, l, i >> (level - l), j >> (level - l)))) {
+            return l;
+        }
+    }
+    return level + 1;
+}
+
+void SurfaceQuadtree::balance(unsigned int instance) {
+    typedef struct {
+        int level;
+        int i;
+        int j;
+    } Node;
+
+    std::vector<Node> queue;
+    for (unsigned long long k : leafKeys) {
+        if ((unsigned int)(k >> 40) == instance) {
+            queue.push_back({ (int)((k >> 32) & 0xFF), (int)((k >> 16) & 0xFFFF), (int)(k & 0xFFFF) });
+        }
+    }
+
+    const int di[] = { -1, 1, 0, 0 };
+    const int dj[] = { 0, 0, -1, 1 };
+
+    while (!queue.empty()) {
+        Node node = queue.back();
+        queue.pop_back();
+        if (!leafKeys.count(key(instance, node.level, node.i, node.j))) {
+            // split since it was queued
+            continue;
+        }
+
+        for (int n = 0; n < 4; n++) {
+            int ni = node.i + di[n];
+            int nj = node.j + dj[n];
+            int neighbourLevel = coveringLevel(instance, node.level, ni, nj);
+            if (neighbourLevel < 0 || neighbourLevel >= node.level - 1) {
+                continue;
+            }
+
+            // split the coarse neighbour, then check this node again
+            int shift = node.level - neighbourLevel;
+            int ci = ni >> shift;
+            int cj = nj >> shift;
+            leafKeys.erase(key(instance, neighbourLevel, ci, cj));
+            for (int c = 0; c < 4; c++) {
+                Node child = { neighbourLevel + 1, 2 * ci + (c & 1), 2 * cj + (c >> 1) };
+                leafKeys.insert(key(instance, child.level, child.i, child.j));
+                queue.push_back(child);
+            }
+            queue.push_back(node);
+            break;
+        }
+    }
+}
+
+void SurfaceQuadtree::collect(unsigned int instance, glm::vec4 root, int level, int i, int j, std::vector<QuadLeaf>& out) {
+    if (!leafKeys.count(key(instance, level, i, j))) {
+        if (level >= maxDepth + 1) {
+            return;
+        }
+        for (int c = 0; c < 4; c++) {
+            collect(instance, root, level + 1, 2 * i + (c & 1), 2 * j + (c >> 1), out);
+        }
+        return;
+    }
+
+    int stitch = 0;
+    if (coveringLevel(instance, level, i - 1, j) == level - 1) {
+        stitch |= QUAD_STITCH_X0;
+    }
+    if (coveringLevel(instance, level, i + 1, j) == level - 1) {
+        stitch |= QUAD_STITCH_X1;
+    }
+    if (coveringLevel(instance, level, i, j - 1) == level - 1) {
+        stitch |= QUAD_STITCH_Z0;
+    }
+    if (coveringLevel(instance, level, i, j + 1) == level - 1) {
+        stitch |= QUAD_STITCH_Z1;
+    }
+
+    out.push_back({ instance, level, i, j, nodeBounds(root, level, i, j), stitch });
+}
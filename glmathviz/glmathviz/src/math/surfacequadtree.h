@@ -0,0 +1,111 @@
+#ifndef SURFACEQUADTREE_H
+#define SURFACEQUADTREE_H
+
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "expression.h"
+
+// edges of a leaf that border a coarser leaf and must be stitched to it
+#define QUAD_STITCH_X0 1
+#define QUAD_STITCH_X1 2
+#define QUAD_STITCH_Z0 4
+#define QUAD_STITCH_Z1 8
+
+typedef struct {
+    unsigned int instance;
+    // node index, i and j in [0, 2^level)
+    int level;
+    int i;
+    int j;
+    glm::vec4 bounds; // x0, z0, x1, z1
+    int stitch; // QUAD_STITCH_* flags
+} QuadLeaf;
+
+/*
+    adaptive subdivision of surface instances into square patches
+    - each leaf is drawn as a patch of patchCells x patchCells cells
+    - a node splits while its curvature estimate, projected from the camera, exceeds the tolerance
+    - neighbouring leaves differ by at most one level, the finer side is stitched to the coarser one
+    - node estimates are cached until the function changes, so camera moves only retraverse the tree
+*/
+
+class SurfaceQuadtree {
+public:
+    // cells per patch side
+    int patchCells;
+    // depth limits (minDepth <= maxDepth, set maxDepth with setMaxDepth)
+    int minDepth;
+    int maxDepth;
+    // largest projected error of a patch (normalized device units, 2 = viewport height)
+    float maxScreenError;
+
+    // leaves of the last build, ordered by instance
+    std::vector<QuadLeaf> leaves;
+
+    /*
+        constructor
+    */
+
+    SurfaceQuadtree(int patchCells = 8, int minDepth = 2, int maxDepth = 6, float maxScreenError = 0.0025f);
+
+    /*
+        state
+    */
+
+    // function y = f(x - xOffset, z, t), clears the cached estimates when it changes
+    void setExpression(ExprPtr expression);
+    void setFunctionState(double xOffset, double t);
+
+    // camera the error is projected with
+    void setCamera(glm::mat4 projView, glm::vec3 viewPos);
+
+    // deepest level, lowers minDepth to it
+    void setMaxDepth(int maxDepth);
+
+    /*
+        subdivision
+    */
+
+    // subdivide the instances (x0, z0, x1, z1), returns if the leaves changed
+    bool build(const std::vector<glm::vec4>& bounds);
+
+private:
+    // world space estimate for one node
+    typedef struct {
+        float error;
+        float yMin;
+        float yMax;
+    } NodeEstimate;
+
+    ExprPtr expression;
+    double xOffset;
+    double t;
+
+    // projection scale of a unit length at unit distance
+    float projScale;
+    glm::vec3 viewPos;
+
+    std::unordered_map<unsigned long long, NodeEstimate> cache;
+    std::unordered_set<unsigned long long> leafKeys;
+
+    static unsigned long long key(unsigned int instance, int level, int i, int j);
+    static glm::vec4 nodeBounds(glm::vec4 root, int level, int i, int j);
+
+    NodeEstimate& estimate(unsigned int instance, glm::vec4 root, int level, int i, int j);
+    bool shouldSplit(unsigned int instance, glm::vec4 root, int level, int i, int j);
+
+    // add the leaves of a node to leafKeys
+    void refine(unsigned int instance, glm::vec4 root, int level, int i, int j);
+    // split leaves until neighbours differ by at most one level
+    void balance(unsigned int instance);
+    // level of the leaf covering node (level, i, j), level + 1 if it is subdivided further, -1 if outside
+    int coveringLevel(unsigned int instance, int level, int i, int j);
+    // append leaves in traversal order
+    void collect(unsigned int instance, glm::vec4 root, int level, int i, int j, std::vector<QuadLeaf>& out);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "glstats.h"
+
+#include <iostream>
+
+/*
+    define initial static values
+*/
+
+GLFrameStats GLStats::current = { 0 };
+GLFrameStats GLStats::last = { 0 };
+bool GLStats::printSummary = false;
+GLuint GLStats::boundProgram = 0;
+
+/*
+    frame
+*/
+
+void GLStats::endFrame() {
+    last = current;
+    current = { 0 };
+
+    if (printSummary) {
+        print(std::cout, last);
+    }
+}
+
+void GLStats::print(std::ostream& out, GLFrameStats stats) {
+    out << "draws " << stats.drawCalls
+        << " | programs " << stats.programBinds << " (" << stats.programSwitches << " switches)"
+        << " | VAO binds " << stats.vaoBinds
+        << " | uniforms " << stats.uniformSets
+        << " | uploads " << stats.uploads << " (" << stats.bytesUploaded << " B)"
+        << std::endl;
+}
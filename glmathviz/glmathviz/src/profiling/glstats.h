@@ -0,0 +1,84 @@
+#ifndef GLSTATS_H
+#define GLSTATS_H
+
+#include <glad/glad.h>
+
+#include <ostream>
+
+/*
+    GL calls and traffic counted through the BufferObject/ArrayObject/Shader wrappers
+*/
+
+typedef struct {
+    unsigned int drawCalls;
+    unsigned int programBinds; // glUseProgram calls
+    unsigned int programSwitches; // glUseProgram calls that changed the bound program
+    unsigned int vaoBinds;
+    unsigned int uniformSets;
+    unsigned int uploads; // glBufferData/glBufferSubData calls
+    unsigned long long bytesUploaded;
+} GLFrameStats;
+
+/*
+    per-frame counters
+*/
+
+class GLStats {
+public:
+    // counters for the frame in progress
+    static GLFrameStats current;
+    // counters of the last finished frame
+    static GLFrameStats last;
+
+    // print a summary line to stdout on every endFrame
+    static bool printSummary;
+
+    /*
+        counting (called from the wrappers)
+    */
+
+    static void countDraw() {
+        current.drawCalls++;
+    }
+
+    static void countProgram(GLuint id) {
+        current.programBinds++;
+        if (id != boundProgram) {
+            current.programSwitches++;
+            boundProgram = id;
+        }
+    }
+
+    static void countVAO() {
+        current.vaoBinds++;
+    }
+
+    static void countUniform() {
+        current.uniformSets++;
+    }
+
+    static void countUpload(unsigned long long bytes) {
+        current.uploads++;
+        current.bytesUploaded += bytes;
+    }
+
+    // forget the bound program (deleted or unbound outside the wrappers)
+    static void resetProgram() {
+        boundProgram = 0;
+    }
+
+    /*
+        frame
+    */
+
+    // finish frame: move current counters into last and reset
+    static void endFrame();
+
+    // print counters on one line
+    static void print(std::ostream& out, GLFrameStats stats);
+
+private:
+    static GLuint boundProgram;
+};
+
+#endif
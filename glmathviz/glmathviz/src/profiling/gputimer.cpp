@@ -0,0 +1,121 @@
+#include "gputimer.h"
+
+#include <algorithm>
+
+/*
+    RollingTimes
+*/
+
+RollingTimes::RollingTimes()
+    : last(0.0), noSamples(0), next(0) {}
+
+void RollingTimes::push(double ms) {
+    last = ms;
+    samples[next] = ms;
+    next = (next + 1) % TIMER_WINDOW;
+    if (noSamples < TIMER_WINDOW) {
+        noSamples++;
+    }
+}
+
+TimingStats RollingTimes::getStats() {
+    TimingStats ret = { 0.0, 0.0, 0.0, noSamples };
+    if (!noSamples) {
+        return ret;
+    }
+
+    // window is small, sort a copy
+    double sorted[TIMER_WINDOW];
+    std::copy(samples, samples + noSamples, sorted);
+    std::sort(sorted, sorted + noSamples);
+
+    double sum = 0.0;
+    for (unsigned int i = 0; i < noSamples; i++) {
+        sum += sorted[i];
+    }
+
+    ret.min = sorted[0];
+    ret.mean = sum / (double)noSamples;
+    ret.p99 = sorted[(unsigned int)(0.99 * (double)(noSamples - 1) + 0.5)];
+
+    return ret;
+}
+
+/*
+    GpuTimer
+*/
+
+GpuTimer::GpuTimer()
+    : next(0), oldest(0), active(false) {
+    for (unsigned int i = 0; i < TIMER_QUERY_RING; i++) {
+        used[i] = 0;
+        pending[i] = false;
+    }
+}
+
+void GpuTimer::begin() {
+    // ring full, GPU is too far behind; drop this sample rather than wait
+    if (pending[next]) {
+        return;
+    }
+
+    if (used[next] == queries[next].size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        queries[next].push_back(query);
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, queries[next][used[next]]);
+    active = true;
+}
+
+void GpuTimer::end() {
+    if (!active) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    used[next]++;
+    active = false;
+}
+
+void GpuTimer::collect(RollingTimes& times) {
+    // close the sample recorded since the last collect
+    if (!pending[next] && used[next]) {
+        pending[next] = true;
+        next = (next + 1) % TIMER_QUERY_RING;
+    }
+
+    // results complete in order, stop at the first unavailable one
+    while (pending[oldest]) {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[oldest][used[oldest] - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        GLuint64 sum = 0;
+        for (unsigned int i = 0; i < used[oldest]; i++) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[oldest][i], GL_QUERY_RESULT, &ns);
+            sum += ns;
+        }
+        times.push((double)sum / 1.0e6);
+
+        used[oldest] = 0;
+        pending[oldest] = false;
+        oldest = (oldest + 1) % TIMER_QUERY_RING;
+    }
+}
+
+void GpuTimer::cleanup() {
+    for (unsigned int i = 0; i < TIMER_QUERY_RING; i++) {
+        if (!queries[i].empty()) {
+            glDeleteQueries((GLsizei)queries[i].size(), &queries[i][0]);
+            queries[i].clear();
+        }
+        used[i] = 0;
+        pending[i] = false;
+    }
+    next = oldest = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// number of samples kept for the rolling statistics
+#define TIMER_WINDOW 128
+// number of samples in flight per phase
+#define TIMER_QUERY_RING 4
+
+/*
+    rolling statistics over the last TIMER_WINDOW samples (milliseconds)
+*/
+
+typedef struct {
+    double min;
+    double mean;
+    double p99;
+    unsigned int count;
+} TimingStats;
+
+class RollingTimes {
+public:
+    // default
+    RollingTimes();
+
+    // add sample, overwriting the oldest when full
+    void push(double ms);
+
+    // compute min/mean/p99 of the current window
+    TimingStats getStats();
+
+    // latest sample
+    double last;
+
+private:
+    double samples[TIMER_WINDOW];
+    unsigned int noSamples;
+    unsigned int next;
+};
+
+/*
+    ring of samples made of GL_TIME_ELAPSED queries
+    - every begin/end pair between two collects adds to the same sample, so work split into
+      several runs (e.g. by the DrawQueue sort) is summed
+    - results are only read once available so the pipeline never stalls
+*/
+
+class GpuTimer {
+public:
+    // default
+    GpuTimer();
+
+    // start query (skipped if every sample in the ring is still pending)
+    void begin();
+
+    // end query started by begin
+    void end();
+
+    // close the current sample and move available results into the rolling times
+    void collect(RollingTimes& times);
+
+    // cleanup
+    void cleanup();
+
+private:
+    // queries of each sample, generated as needed
+    std::vector<GLuint> queries[TIMER_QUERY_RING];
+    unsigned int used[TIMER_QUERY_RING]; // queries issued into the sample
+    bool pending[TIMER_QUERY_RING];
+    unsigned int next; // sample being recorded
+    unsigned int oldest; // oldest pending sample
+    bool active;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "programtimer.h"
+#include "tracer.h"
+#include "../util/threadpool.h"
+
+#include <iomanip>
+
+/*
+    ProgramTimer
+*/
+
+std::vector<ProgramTimer> ProgramTimer::timers;
+std::vector<char> ProgramTimer::changed;
+
+ProgramTimer::ProgramTimer(Program* program, const char* name)
+    : program(program), name(name) {}
+
+double elapsedMs(ProgramTimer::Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(ProgramTimer::Clock::now() - start).count();
+}
+
+bool ProgramTimer::update(double dt) {
+    TRACE_SCOPE_DETAIL("Program::update", "update", name);
+
+    Clock::time_point start = Clock::now();
+    bool ret = program->update(dt);
+    cpuUpdate.push(elapsedMs(start));
+
+    return ret;
+}
+
+void ProgramTimer::upload() {
+    updateQueries.collect(gpuUpdate);
+    if (program->uploads.empty()) {
+        return;
+    }
+
+    TRACE_SCOPE_DETAIL("Program::upload", "update", name);
+    updateQueries.begin();
+    program->uploads.replay();
+    updateQueries.end();
+}
+
+void ProgramTimer::render(DrawQueue& queue) {
+    TRACE_SCOPE_DETAIL("Program::render", "render", name);
+    renderQueries.collect(gpuRender);
+
+    Clock::time_point start = Clock::now();
+    queue.setTimer(&renderQueries);
+    program->render(queue);
+    queue.setTimer(nullptr);
+    cpuRender.push(elapsedMs(start));
+}
+
+ProgramTimings ProgramTimer::getTimings() {
+    return {
+        name,
+        cpuUpdate.getStats(),
+        cpuRender.getStats(),
+        gpuUpdate.getStats(),
+        gpuRender.getStats()
+    };
+}
+
+void ProgramTimer::cleanup() {
+    updateQueries.cleanup();
+    renderQueries.cleanup();
+}
+
+ProgramTimer& ProgramTimer::registerProgram(Program* program, const char* name) {
+    timers.push_back(ProgramTimer(program, name));
+    return timers.back();
+}
+
+bool ProgramTimer::updateAll(double dt) {
+    changed.assign(timers.size(), 0);
+    ThreadPool::shared().parallelFor((unsigned int)timers.size(), [dt](unsigned int i) {
+        changed[i] = timers[i].update(dt);
+    });
+
+    bool ret = false;
+    for (unsigned int i = 0; i < timers.size(); i++) {
+        timers[i].upload();
+        ret |= (bool)changed[i];
+    }
+
+    return ret;
+}
+
+std::vector<ProgramTimings> ProgramTimer::getAllTimings() {
+    std::vector<ProgramTimings> ret;
+    for (ProgramTimer& timer : timers) {
+        ret.push_back(timer.getTimings());
+    }
+    return ret;
+}
+
+void printStats(std::ostream& out, const char* label, TimingStats stats) {
+    out << "  " << std::left << std::setw(12) << label << std::right
+        << " min " << std::setw(9) << stats.min
+        << " mean " << std::setw(9) << stats.mean
+        << " p99 " << std::setw(9) << stats.p99
+        << " (" << stats.count << ")" << std::endl;
+}
+
+void ProgramTimer::print(std::ostream& out) {
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "Program timings (ms, last " << TIMER_WINDOW << " frames)" << std::endl;
+    for (ProgramTimings timings : getAllTimings()) {
+        out << timings.name << std::endl;
+        printStats(out, "cpu update", timings.cpuUpdate);
+        printStats(out, "cpu render", timings.cpuRender);
+        printStats(out, "gpu update", timings.gpuUpdate);
+        printStats(out, "gpu render", timings.gpuRender);
+    }
+
+    out.flags(flags);
+}
+
+void ProgramTimer::cleanupAll() {
+    for (ProgramTimer& timer : timers) {
+        timer.cleanup();
+    }
+    timers.clear();
+}
@@ -0,0 +1,101 @@
+#ifndef PROGRAMTIMER_H
+#define PROGRAMTIMER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <vector>
+#include <ostream>
+
+#include "gputimer.h"
+#include "../programs/program.h"
+
+/*
+    timing results for one program
+*/
+
+typedef struct {
+    const char* name;
+    TimingStats cpuUpdate;
+    TimingStats cpuRender;
+    TimingStats gpuUpdate;
+    TimingStats gpuRender;
+} ProgramTimings;
+
+/*
+    class to wrap Program::update and Program::render in CPU and GPU timers
+*/
+
+class ProgramTimer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // wrapped program
+    Program* program;
+    const char* name;
+
+    // measured times
+    RollingTimes cpuUpdate;
+    RollingTimes cpuRender;
+    RollingTimes gpuUpdate;
+    RollingTimes gpuRender;
+
+    /*
+        constructor
+    */
+
+    ProgramTimer(Program* program, const char* name);
+
+    /*
+        timed calls
+    */
+
+    // timed Program::update (CPU only, may run on a worker thread)
+    bool update(double dt);
+
+    // replay the uploads recorded by update (GL thread)
+    // - GPU update time covers the replayed writes
+    void upload();
+
+    // timed Program::render
+    // - CPU time covers queuing the packets, GPU time is measured when the queue is flushed
+    void render(DrawQueue& queue);
+
+    // statistics for this program
+    ProgramTimings getTimings();
+
+    // delete queries
+    void cleanup();
+
+    /*
+        static
+    */
+
+    // registered timers, in registration order
+    static std::vector<ProgramTimer> timers;
+
+    // register program to be timed
+    static ProgramTimer& registerProgram(Program* program, const char* name);
+
+    // update all programs in parallel on the shared pool, then replay their uploads
+    // - returns if any program changed
+    static bool updateAll(double dt);
+
+    // statistics for all registered programs
+    static std::vector<ProgramTimings> getAllTimings();
+
+    // print statistics table
+    static void print(std::ostream& out);
+
+    // delete all queries and clear registry
+    static void cleanupAll();
+
+private:
+    // per-program results of updateAll
+    static std::vector<char> changed;
+
+    GpuTimer updateQueries;
+    GpuTimer renderQueries;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "tracer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+
+/*
+    define initial static values
+*/
+
+std::atomic<bool> Tracer::enabled(false);
+Tracer::Clock::time_point Tracer::origin;
+std::string Tracer::outPath;
+std::atomic<TraceBuffer*> Tracer::buffers(nullptr);
+std::atomic<unsigned int> Tracer::nextTid(1);
+
+TraceChunk* newChunk() {
+    TraceChunk* chunk = new TraceChunk;
+    chunk->count.store(0, std::memory_order_relaxed);
+    chunk->next = nullptr;
+    return chunk;
+}
+
+void deleteBuffer(TraceBuffer* buffer) {
+    TraceChunk* chunk = buffer->head;
+    while (chunk) {
+        TraceChunk* next = chunk->next;
+        delete chunk;
+        chunk = next;
+    }
+    delete buffer;
+}
+
+// releases the buffer of a thread when it exits
+struct TraceBufferOwner {
+    TraceBuffer* buffer = nullptr;
+
+    ~TraceBufferOwner() {
+        if (buffer) {
+            Tracer::releaseBuffer(buffer, TRACE_BUFFER_EXITED);
+        }
+    }
+};
+
+/*
+    control
+*/
+
+void Tracer::start(const char* outPath) {
+    Tracer::outPath = outPath;
+    origin = Clock::now();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::startFromEnv(const char* var) {
+    const char* path = getenv(var);
+    if (path && path[0]) {
+        start(path);
+    }
+}
+
+// write string with JSON escapes
+void writeEscaped(std::ostream& out, const char* str) {
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            out << '\\';
+        }
+        out << *str;
+    }
+}
+
+void Tracer::stop() {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    enabled.store(false, std::memory_order_relaxed);
+
+    // take all buffers, threads recording again start new ones
+    TraceBuffer* list = buffers.exchange(nullptr, std::memory_order_acquire);
+
+    std::ofstream file(outPath);
+    if (!file.is_open()) {
+        std::cout << "Could not open " << outPath << std::endl;
+    }
+    else {
+        write(file, list);
+    }
+
+    TraceBuffer* buffer = list;
+    while (buffer) {
+        TraceBuffer* next = buffer->next;
+        releaseBuffer(buffer, TRACE_BUFFER_WRITTEN);
+        buffer = next;
+    }
+}
+
+void Tracer::write(std::ostream& file, TraceBuffer* list) {
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    bool first = true;
+    for (TraceBuffer* buffer = list; buffer; buffer = buffer->next) {
+        for (TraceChunk* chunk = buffer->head; chunk; chunk = chunk->next) {
+            unsigned int count = chunk->count.load(std::memory_order_acquire);
+            for (unsigned int i = 0; i < count; i++) {
+                TraceEvent& e = chunk->events[i];
+
+                file << (first ? "" : ",\n")
+                    << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                    << ",\"ts\":" << e.start << ",\"dur\":" << e.duration
+                    << ",\"cat\":\"" << e.category << "\",\"name\":\"" << e.name << "\"";
+                if (e.detail[0]) {
+                    file << ",\"args\":{\"detail\":\"";
+                    writeEscaped(file, e.detail);
+                    file << "\"}";
+                }
+                file << "}";
+
+                first = false;
+            }
+        }
+    }
+    file << std::endl << "]}" << std::endl;
+}
+
+/*
+    recording
+*/
+
+void Tracer::releaseBuffer(TraceBuffer* buffer, int state) {
+    // the second owner to let go frees the buffer
+    if (buffer->state.exchange(state, std::memory_order_acq_rel) != TRACE_BUFFER_LIVE) {
+        deleteBuffer(buffer);
+    }
+}
+
+TraceBuffer* Tracer::getThreadBuffer() {
+    thread_local TraceBufferOwner owner;
+    TraceBuffer*& buffer = owner.buffer;
+    if (buffer && buffer->state.load(std::memory_order_acquire) == TRACE_BUFFER_WRITTEN) {
+        // written by a previous stop, only this thread still holds it
+        deleteBuffer(buffer);
+        buffer = nullptr;
+    }
+    if (!buffer) {
+        buffer = new TraceBuffer;
+        buffer->tid = nextTid.fetch_add(1);
+        buffer->head = buffer->tail = newChunk();
+        buffer->state.store(TRACE_BUFFER_LIVE, std::memory_order_relaxed);
+
+        // push onto the global list
+        buffer->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(buffer->next, buffer,
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    return buffer;
+}
+
+void Tracer::record(const char* name, const char* category, const char* detail,
+    Clock::time_point start, Clock::time_point end) {
+    TraceBuffer* buffer = getThreadBuffer();
+
+    TraceChunk* chunk = buffer->tail;
+    unsigned int count = chunk->count.load(std::memory_order_relaxed);
+    if (count >= TRACE_CHUNK_SIZE) {
+        // chunk full, link a new one
+        chunk->next = newChunk();
+        chunk = buffer->tail = chunk->next;
+        count = 0;
+    }
+
+    TraceEvent& e = chunk->events[count];
+    e.name = name;
+    e.category = category;
+    e.detail[0] = 0;
+    if (detail) {
+        strncpy(e.detail, detail, TRACE_DETAIL_LENGTH - 1);
+        e.detail[TRACE_DETAIL_LENGTH - 1] = 0;
+    }
+    e.start = std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count();
+    e.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    // publish event
+    chunk->count.store(count + 1, std::memory_order_release);
+}
@@ -0,0 +1,129 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+// events per chunk of a thread buffer
+#define TRACE_CHUNK_SIZE 4096
+// max characters kept from a span detail (program name, shader path)
+#define TRACE_DETAIL_LENGTH 48
+
+/*
+    recorded span ("complete" event in the trace-event format)
+*/
+
+typedef struct {
+    const char* name;
+    const char* category;
+    char detail[TRACE_DETAIL_LENGTH];
+    long long start; // microseconds since Tracer::start
+    long long duration; // microseconds
+} TraceEvent;
+
+/*
+    per-thread buffer, a linked list of fixed size chunks
+    - only the owning thread appends, so recording takes no locks
+    - freed by whichever of the owning thread's exit and Tracer::stop comes last
+*/
+
+typedef struct TraceChunk {
+    TraceEvent events[TRACE_CHUNK_SIZE];
+    std::atomic<unsigned int> count;
+    TraceChunk* next;
+} TraceChunk;
+
+// states of a TraceBuffer
+#define TRACE_BUFFER_LIVE 0
+#define TRACE_BUFFER_EXITED 1 // owning thread exited, events not written yet
+#define TRACE_BUFFER_WRITTEN 2 // events written and buffer unlinked by Tracer::stop
+
+typedef struct TraceBuffer {
+    unsigned int tid;
+    TraceChunk* head;
+    TraceChunk* tail;
+    TraceBuffer* next;
+    std::atomic<int> state;
+} TraceBuffer;
+
+/*
+    opt-in tracer writing chrome://tracing / Perfetto JSON
+*/
+
+class Tracer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // if spans are recorded (read by every thread opening a span)
+    static std::atomic<bool> enabled;
+
+    // start recording, trace is written to outPath on stop
+    static void start(const char* outPath);
+
+    // start recording if the environment variable is set to an output path
+    static void startFromEnv(const char* var = "GLMATHVIZ_TRACE");
+
+    // stop recording and write the trace file
+    static void stop();
+
+    // record a finished span on the calling thread
+    static void record(const char* name, const char* category, const char* detail,
+        Clock::time_point start, Clock::time_point end);
+
+private:
+    static Clock::time_point origin;
+    static std::string outPath;
+
+    // all thread buffers (lock-free push)
+    static std::atomic<TraceBuffer*> buffers;
+    static std::atomic<unsigned int> nextTid;
+
+    // write the events of a buffer list as JSON
+    static void write(std::ostream& file, TraceBuffer* list);
+
+    // buffer of the calling thread
+    static TraceBuffer* getThreadBuffer();
+
+    // release a buffer from one of its two owners (thread exit, stop) with the given state
+    static void releaseBuffer(TraceBuffer* buffer, int state);
+
+    friend struct TraceBufferOwner;
+};
+
+/*
+    records the lifetime of the scope as a span
+*/
+
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category, const char* detail = nullptr)
+        : name(name), category(category), detail(detail), active(Tracer::enabled.load(std::memory_order_relaxed)) {
+        if (active) {
+            start = Tracer::Clock::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (active) {
+            Tracer::record(name, category, detail, start, Tracer::Clock::now());
+        }
+    }
+
+private:
+    const char* name;
+    const char* category;
+    const char* detail;
+    bool active;
+    Tracer::Clock::time_point start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// trace the enclosing scope
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#define TRACE_SCOPE_DETAIL(name, category, detail) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category, detail)
+
+#endif
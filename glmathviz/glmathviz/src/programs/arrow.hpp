@@ -3,45 +3,130 @@
 
 #include <glm/glm.hpp>
 
+#include <math.h>
 #include <vector>
 
 #include "program.h"
 #include "../rendering/shader.h"
 #include "../rendering/material.h"
 #include "../rendering/vertexmemory.hpp"
+#include "../rendering/arrowmesh.hpp"
+#include "../rendering/transition.hpp"
+#include "../math/frustum.h"
 
 #ifndef ARROW_HPP
 #define ARROW_HPP
 
+// attributes of one arrow
+typedef struct {
+	glm::vec4 dimensions; // magnitude, arm_radius, head_radius, head_height
+	glm::mat4 model;
+	glm::mat3 normalModel;
+	glm::vec3 diffuse;
+	glm::vec4 specular; // specular, shininess
+} ArrowInstance;
+
+/*
+	arrows drawn as instances of the shared unit arrow mesh (see ArrowMesh), scaled in arrow.vert
+	- the level of detail of every arrow is picked by its projected size when the camera or viewport changes
+	- arrows outside the view or smaller than a pixel are not drawn
+	- the instance buffer is sorted by level, each level drawn in one call from its own VAO
+	- one instance can follow a ParametrizedPath, oriented by the path's Frenet frame
+*/
+
 class Arrow : public Program {
 	unsigned int noInstances;
 	unsigned int maxNoInstances;
 
-	std::vector<glm::vec4> dimensions; // magnitude, arm_radius, head_radius, head_height
-	std::vector<glm::mat4> modelMats;
-	std::vector<glm::mat3> normalModelMats;
-	std::vector<glm::vec3> diffuse;
-	std::vector<glm::vec4> specular; // specular, shininess
+	std::vector<ArrowInstance> instances;
+	// instances sorted by level of detail, as in the instance buffer
+	std::vector<ArrowInstance> sorted;
 
-	ArrayObject VAO;
+	// bounding sphere of every instance (center, radius)
+	std::vector<glm::vec4> spheres;
 
-public:
-	Arrow(unsigned int maxNoInstances)
-		: maxNoInstances(maxNoInstances), noInstances(0) {}
+	// one VAO per level, its instance attributes starting at the level's first instance
+	ArrayObject lodVAOs[ARROW_NO_LODS];
+	BufferObject instanceVBO;
+	ArrowMesh* mesh;
 
-	bool addInstance(glm::vec3 start, glm::vec3 end, float armRadius, float headRadius, float headHeight, Material material) {
-		if (noInstances >= maxNoInstances || start == end) {
-			return false;
+	// instances of every level, first instance the VAOs currently point to
+	unsigned int lodFirst[ARROW_NO_LODS];
+	unsigned int lodCount[ARROW_NO_LODS];
+	unsigned int pointedFirst[ARROW_NO_LODS];
+
+	glm::mat4 projView;
+	int viewportHeight;
+	bool lodsDirty;
+
+	// path followed by the instance at pathInstance (see addPathInstance)
+	ParametrizedPath* path;
+	unsigned int pathInstance;
+
+	// instance attributes of a level's VAO, starting at instance first
+	void pointAttributes(int lod, unsigned int first) {
+		GLuint offset = first * (sizeof(ArrowInstance) / sizeof(GLfloat));
+		lodVAOs[lod].bind();
+		instanceVBO.bind();
+		instanceVBO.setAttPointer<GLfloat>(0, 4, GL_FLOAT, 36, offset + 0, 1);
+		instanceVBO.setAttPointer<GLfloat>(1, 4, GL_FLOAT, 36, offset + 4, 1);
+		instanceVBO.setAttPointer<GLfloat>(2, 4, GL_FLOAT, 36, offset + 8, 1);
+		instanceVBO.setAttPointer<GLfloat>(3, 4, GL_FLOAT, 36, offset + 12, 1);
+		instanceVBO.setAttPointer<GLfloat>(4, 4, GL_FLOAT, 36, offset + 16, 1);
+		instanceVBO.setAttPointer<GLfloat>(5, 3, GL_FLOAT, 36, offset + 20, 1);
+		instanceVBO.setAttPointer<GLfloat>(6, 3, GL_FLOAT, 36, offset + 23, 1);
+		instanceVBO.setAttPointer<GLfloat>(7, 3, GL_FLOAT, 36, offset + 26, 1);
+		instanceVBO.setAttPointer<GLfloat>(8, 3, GL_FLOAT, 36, offset + 29, 1);
+		instanceVBO.setAttPointer<GLfloat>(9, 4, GL_FLOAT, 36, offset + 32, 1);
+		pointedFirst[lod] = first;
+	}
+
+	// sort the visible instances into levels by projected size and upload them
+	void selectLods() {
+		Frustum frustum(projView);
+		// focal length of the projection (length of the second row of projView, NDC units)
+		float focal = glm::length(glm::vec3(projView[0][1], projView[1][1], projView[2][1]));
+
+		std::vector<unsigned int> levels[ARROW_NO_LODS];
+		for (unsigned int i = 0; i < noInstances; i++) {
+			glm::vec3 center(spheres[i]);
+			float radius = spheres[i].w;
+			if (!frustum.intersects(center - radius, center + radius)) {
+				continue;
+			}
+
+			// diameter in pixels, everything is large when the camera is inside the sphere
+			float w = (projView * glm::vec4(center, 1.0f)).w;
+			float pixels = w > radius ? radius * focal / w * (float)viewportHeight : arrowLodPixels[0];
+			int lod = 0;
+			while (lod < ARROW_NO_LODS && pixels < arrowLodPixels[lod]) {
+				lod++;
+			}
+			if (lod < ARROW_NO_LODS) {
+				levels[lod].push_back(i);
+			}
 		}
 
-		// calculate model matrix
-		glm::mat4 mat(1.0f);
-		glm::vec3 armVector = glm::normalize(end - start);
+		sorted.clear();
+		for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+			lodFirst[lod] = (unsigned int)sorted.size();
+			lodCount[lod] = (unsigned int)levels[lod].size();
+			for (unsigned int i : levels[lod]) {
+				sorted.push_back(instances[i]);
+			}
+		}
+
+		if (!sorted.empty()) {
+			instanceVBO.bind();
+			instanceVBO.updateData<ArrowInstance>(0, (GLuint)sorted.size(), &sorted[0]);
+		}
+		lodsDirty = false;
+	}
 
-		// determine vectors
+	// orthonormal basis of the plane perpendicular to the unit armVector, false for a zero vector
+	static bool perpendicularBasis(glm::vec3 armVector, glm::vec3& u, glm::vec3& v) {
 		// arm vector perpendicular to plane with equation ax*x + ay*y + az*z = 0
 		// get basis of the plane containing the base of the cylinder by isolating variable
-		glm::vec3 u, v;
 		if (armVector.y != 0.0f)
 		{
 			// y = -(ax*x + az*z)/ay
@@ -62,98 +147,203 @@ public:
 		}
 		else
 		{
-			// two points are the same
 			return false;
 		}
 
 		// orthogonalize v with respect to u, armVector
 		// v = glm::normalize(glm::cross(armVector, u)); // more expensive operation
 		v = glm::normalize(v - u * glm::dot(u, v)); // orthogonalization
+		return true;
+	}
+
+	// new instance with its dimensions and material, placed by placeInstance
+	void pushInstance(float magnitude, float armRadius, float headRadius, float headHeight, Material material) {
+		instances.push_back({
+			glm::vec4(magnitude, armRadius, headRadius, headHeight),
+			glm::mat4(1.0f),
+			glm::mat3(1.0f),
+			material.diffuse,
+			glm::vec4(material.specular, material.shininess)
+		});
+		spheres.push_back(glm::vec4(0.0f));
+		noInstances++;
+	}
 
+	// move instance i to start, its arm along the unit armVector and its base spanned by u, v
+	void placeInstance(unsigned int i, glm::vec3 start, glm::vec3 armVector, glm::vec3 u, glm::vec3 v) {
 		/*
-			in geometry shader, arrow drawn with base in XZ plane (y = 0) and arm along y-axis
+			in arrow.vert, the unit arrow has its base in the XZ plane (y = 0) and its arm along the y-axis
 			transform y unit vector to be along the armVector
 			transform x/z unit vectors to be in the plane of the base, perpendicular to the arm
 		*/
+		glm::mat4 mat(1.0f);
 		mat[0] = glm::vec4(u, 0.0f); // how x unit vector gets transformed
 		mat[1] = glm::vec4(armVector, 0.0f); // how y unit vector gets transformed
 		mat[2] = glm::vec4(v, 0.0f); // how z unit vector gets transformed
 		mat[3] = glm::vec4(start, 1.0f); // translation to start point
-		modelMats.push_back(mat);
-		normalModelMats.push_back(glm::transpose(glm::inverse(glm::mat3(mat))));
 
-		dimensions.push_back({ glm::length(end - start), armRadius, headRadius, headHeight });
-		diffuse.push_back(material.diffuse);
-		specular.push_back(glm::vec4(material.specular, material.shininess));
+		instances[i].model = mat;
+		instances[i].normalModel = glm::transpose(glm::inverse(glm::mat3(mat)));
 
-		noInstances++;
+		// sphere around the middle of the arm, wide enough for the head
+		float halfLength = 0.5f * instances[i].dimensions.x;
+		float headRadius = instances[i].dimensions.z;
+		spheres[i] = glm::vec4(start + halfLength * armVector,
+			sqrt(halfLength * halfLength + headRadius * headRadius));
+
+		lodsDirty = true;
+	}
+
+	// place the path instance at the current point of the path, in its Frenet frame
+	void followPath() {
+		// binormal x tangent = normal keeps the frame right-handed like x, y, z
+		glm::vec3 tangent = path->getTangent();
+		glm::vec3 u = path->getBinormal();
+		glm::vec3 v = path->getNormal();
+		if (tangent == glm::vec3(0.0f)) {
+			// path stands still, keep the last direction
+			return;
+		}
+		if (u == glm::vec3(0.0f)) {
+			// no normal or binormal where the path is straight
+			perpendicularBasis(tangent, u, v);
+		}
+
+		placeInstance(pathInstance, path->getCurrent(), tangent, u, v);
+	}
+
+public:
+	Arrow(unsigned int maxNoInstances)
+		: maxNoInstances(maxNoInstances), noInstances(0), mesh(nullptr),
+		projView(1.0f), viewportHeight(0), lodsDirty(true),
+		path(nullptr), pathInstance(0) {
+		for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+			lodFirst[lod] = lodCount[lod] = pointedFirst[lod] = 0;
+		}
+	}
+
+	bool addInstance(glm::vec3 start, glm::vec3 end, float armRadius, float headRadius, float headHeight, Material material) {
+		if (noInstances >= maxNoInstances || start == end) {
+			return false;
+		}
+
+		glm::vec3 armVector = glm::normalize(end - start);
+		glm::vec3 u, v;
+		if (!perpendicularBasis(armVector, u, v)) {
+			// two points are the same
+			return false;
+		}
+
+		pushInstance(glm::length(end - start), armRadius, headRadius, headHeight, material);
+		placeInstance(noInstances - 1, start, armVector, u, v);
+
+		return true;
+	}
+
+	// arrow of length magnitude riding along path, pointing along its tangent (see update)
+	bool addPathInstance(ParametrizedPath* path, float magnitude, float armRadius, float headRadius, float headHeight, Material material) {
+		if (noInstances >= maxNoInstances || this->path) {
+			return false;
+		}
+
+		this->path = path;
+		pathInstance = noInstances;
+		pushInstance(magnitude, armRadius, headRadius, headHeight, material);
+		followPath();
 
 		return true;
 	}
 
 	void load() {
-		shader = Shader(false, "arrow.vert", "dirlight.frag", "arrow.geom");
+		shader = Shader(false, "arrow.vert", "dirlight.frag");
 
 		if (!noInstances) {
 			return;
 		}
 
-		VAO.generate();
-		VAO.bind();
+		instanceVBO = BufferObject(GL_ARRAY_BUFFER);
+		instanceVBO.generate();
+		instanceVBO.bind();
+		instanceVBO.setData<ArrowInstance>(noInstances, &instances[0], GL_DYNAMIC_DRAW);
 
-		VAO["dimVBO"] = BufferObject(GL_ARRAY_BUFFER);
-		VAO["dimVBO"].generate();
-		VAO["dimVBO"].bind();
-		VAO["dimVBO"].setData<glm::vec4>(noInstances, &dimensions[0], GL_STATIC_DRAW);
-		VAO["dimVBO"].setAttPointer<GLfloat>(0, 4, GL_FLOAT, 4, 0);
+		for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+			lodVAOs[lod].generate();
+			pointAttributes(lod, 0);
+			if (!mesh) {
+				mesh = ArrowMesh::acquire(10);
+			}
+			else {
+				mesh->attach(10);
+			}
+		}
+		ArrayObject::clear();
+		lodsDirty = true;
+	}
 
-		VAO["matVBO"] = BufferObject(GL_ARRAY_BUFFER);
-		VAO["matVBO"].generate();
-		VAO["matVBO"].bind();
-		VAO["matVBO"].setData<glm::mat4>(noInstances, &modelMats[0], GL_STATIC_DRAW);
-		VAO["matVBO"].setAttPointer<glm::vec4>(1, 4, GL_FLOAT, 4, 0);
-		VAO["matVBO"].setAttPointer<glm::vec4>(2, 4, GL_FLOAT, 4, 1);
-		VAO["matVBO"].setAttPointer<glm::vec4>(3, 4, GL_FLOAT, 4, 2);
-		VAO["matVBO"].setAttPointer<glm::vec4>(4, 4, GL_FLOAT, 4, 3);
+	bool update(double dt) {
+		if (path && noInstances && path->isRunning()) {
+			followPath();
+			return true;
+		}
 
-		VAO["normVBO"] = BufferObject(GL_ARRAY_BUFFER);
-		VAO["normVBO"].generate();
-		VAO["normVBO"].bind();
-		VAO["normVBO"].setData<glm::mat3>(noInstances, &normalModelMats[0], GL_STATIC_DRAW);
-		VAO["normVBO"].setAttPointer<glm::vec3>(5, 3, GL_FLOAT, 3, 0);
-		VAO["normVBO"].setAttPointer<glm::vec3>(6, 3, GL_FLOAT, 3, 1);
-		VAO["normVBO"].setAttPointer<glm::vec3>(7, 3, GL_FLOAT, 3, 2);
+		return false;
+	}
 
-		VAO["diffVBO"] = BufferObject(GL_ARRAY_BUFFER);
-		VAO["diffVBO"].generate();
-		VAO["diffVBO"].bind();
-		VAO["diffVBO"].setData<glm::vec3>(noInstances, &diffuse[0], GL_STATIC_DRAW);
-		VAO["diffVBO"].setAttPointer<GLfloat>(8, 3, GL_FLOAT, 3, 0);
+	double nextUpdate() {
+		return path && noInstances ? path->nextChange() : FrameScheduler::never;
+	}
 
-		VAO["specVBO"] = BufferObject(GL_ARRAY_BUFFER);
-		VAO["specVBO"].generate();
-		VAO["specVBO"].bind();
-		VAO["specVBO"].setData<glm::vec4>(noInstances, &specular[0], GL_STATIC_DRAW);
-		VAO["specVBO"].setAttPointer<GLfloat>(9, 4, GL_FLOAT, 4, 0);
+	void cameraChanged(glm::mat4 projView, glm::vec3 viewPos) {
+		this->projView = projView;
+		lodsDirty = true;
 	}
 
-	void render() {
-		shader.activate();
-		VAO.bind();
-		VAO.draw(GL_POINTS, 0, noInstances);
+	void viewportChanged(int width, int height) {
+		if (height != viewportHeight) {
+			viewportHeight = height;
+			lodsDirty = true;
+		}
+	}
+
+	void render(DrawQueue& queue) {
+		if (!noInstances) {
+			return;
+		}
+
+		if (lodsDirty) {
+			selectLods();
+			for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+				if (lodCount[lod] && lodFirst[lod] != pointedFirst[lod]) {
+					pointAttributes(lod, lodFirst[lod]);
+				}
+			}
+			ArrayObject::clear();
+		}
+
+		for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+			if (lodCount[lod]) {
+				queue.draw(shader, lodVAOs[lod], GL_TRIANGLES, mesh->noIndices[lod], GL_UNSIGNED_INT,
+					mesh->indexOffset(lod), lodCount[lod]);
+			}
+		}
 	}
 
 	void cleanup() {
 		noInstances = 0;
+		path = nullptr;
 
-		dimensions.clear();
-		modelMats.clear();
-		normalModelMats.clear();
-		diffuse.clear();
-		specular.clear();
+		instances.clear();
+		sorted.clear();
+		spheres.clear();
 
 		shader.cleanup();
-		VAO.cleanup();
+		for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+			lodVAOs[lod].cleanup();
+			lodFirst[lod] = lodCount[lod] = pointedFirst[lod] = 0;
+		}
+		instanceVBO.cleanup();
+		ArrowMesh::release(mesh);
+		mesh = nullptr;
 	}
 };
 
@@ -0,0 +1,232 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <string>
+#include <stdlib.h>
+#include <iostream>
+
+#include "program.h"
+#include "../rendering/shader.h"
+#include "../rendering/vertexmemory.hpp"
+#include "../rendering/shadervariants.hpp"
+#include "../math/expression.h"
+#include "../io/framescheduler.h"
+#include "../io/keyboard.h"
+
+#ifndef COMPLEXPLANE_HPP
+#define COMPLEXPLANE_HPP
+
+// functions cycled through with J
+const char* const complexPresets[] = {
+	"(z^2 - 1) * (z - 2 - i)^2 / (z^2 + 2 + 2*i)",
+	"sin(1 / z)",
+	"(z^5 - 1) / (z - 1)",
+	"exp(i * t) * z^3 - 1 / z"
+};
+
+/*
+	domain coloring of a complex function w = f(z, t)
+	- evaluated per fragment of a fullscreen triangle, so the cost does not depend on the function's features
+	- hue from arg w, brightness from log |w|
+	- the double-float variant (K) keeps pixels distinct at zooms beyond float precision
+*/
+
+class ComplexPlane : public Program {
+	// no attributes, the triangle comes from gl_VertexID
+	ArrayObject VAO;
+
+	// view center and half height in the complex plane
+	glm::dvec2 center;
+	double scale;
+	float aspect;
+	bool viewDirty;
+
+	bool df64;
+
+	// function w = f(z, t)
+	ExprPtr expression;
+	unsigned int preset;
+	double time;
+
+	// compiled programs by hash of the generated source
+	ShaderVariants variants;
+	bool loaded;
+
+	UniformHandle<float> timeUniform;
+	UniformHandle<glm::vec4> centerUniform;
+	UniformHandle<glm::vec2> extentUniform;
+
+	// shader library file contents
+	std::string loadLibrary(const char* file) {
+		char* src = Shader::loadShaderSrc(false, file);
+		std::string ret = src ? src : "";
+		free(src);
+		return ret;
+	}
+
+	// GLSL defining evaluate (complex library of the selected precision followed by the function)
+	std::string generateSource() {
+		return std::string("#version 330 core\n")
+			+ (df64 ? "#extension GL_ARB_gpu_shader5 : enable\n" : "")
+			+ loadLibrary("complex.glsl")
+			+ loadLibrary(df64 ? "complex_df64.glsl" : "complex_float.glsl")
+			+ "uniform float time;\n"
+			"uniform vec4 center;\n"
+			"vec2 evaluate(vec2 offset) {\n"
+			"	C z = cposition(center, offset);\n"
+			"	return cvalue(" + expression->toComplexGLSL() + ");\n"
+			"}\n";
+	}
+
+	// switch to the variant for the current function and precision, compiling it on first use
+	void useVariant() {
+		std::string src = generateSource();
+		unsigned long long key = Expression::hash(src);
+
+		Shader* variant = variants.find(key, src);
+		if (!variant) {
+			Shader compiled;
+			compiled.generate(false, "complexplane.vert", "complexplane.frag", nullptr, GL_FRAGMENT_SHADER, src);
+			variant = variants.add(key, src, compiled);
+		}
+
+		// uniforms are per program, restore the current state
+		shader = *variant;
+		shader.activate();
+		timeUniform = shader.getUniform<float>("time");
+		centerUniform = shader.getUniform<glm::vec4>("center");
+		extentUniform = shader.getUniform<glm::vec2>("extent");
+		timeUniform.set((float)time);
+		viewDirty = true;
+	}
+
+	// zoom by factor about the center, pan by a fraction of the view
+	void moveView(glm::dvec2 pan, double zoom) {
+		center += pan * scale;
+		scale *= zoom;
+		viewDirty = true;
+	}
+
+public:
+	ComplexPlane(const char* expression = complexPresets[0],
+		glm::dvec2 center = glm::dvec2(0.0), double scale = 3.0, bool df64 = false)
+		: center(center), scale(scale), aspect(1.0f), viewDirty(true), df64(df64),
+		preset(0), time(0.0), loaded(false) {
+		if (!setExpression(expression)) {
+			setExpression(complexPresets[0]);
+		}
+	}
+
+	// parse and use a new function f(z, t), keeps the current one on a parse error
+	bool setExpression(const std::string& src) {
+		std::string error;
+		ExprPtr parsed = Expression::parse(src, error, "zit");
+		if (!parsed) {
+			std::cout << "Could not parse complex function \"" << src << "\": " << error << std::endl;
+			return false;
+		}
+
+		expression = parsed;
+		if (loaded) {
+			useVariant();
+		}
+		return true;
+	}
+
+	// view centered on center with half height scale
+	void setView(glm::dvec2 center, double scale) {
+		this->center = center;
+		this->scale = scale;
+		viewDirty = true;
+	}
+
+	void setDoublePrecision(bool df64) {
+		this->df64 = df64;
+		if (loaded) {
+			useVariant();
+		}
+	}
+
+	void load() {
+		loaded = true;
+		useVariant();
+
+		VAO.generate();
+	}
+
+	bool update(double dt) {
+		if (expression->dependsOn('t')) {
+			time += dt;
+			uploads.setUniform<float>(shader, timeUniform, (float)time);
+			return true;
+		}
+
+		return false;
+	}
+
+	double nextUpdate() {
+		return expression->dependsOn('t') ? 0.0 : FrameScheduler::never;
+	}
+
+	void viewportChanged(int width, int height) {
+		float viewportAspect = height ? (float)width / (float)height : 1.0f;
+		if (viewportAspect != aspect) {
+			aspect = viewportAspect;
+			viewDirty = true;
+		}
+	}
+
+	void render(DrawQueue& queue) {
+		if (viewDirty) {
+			// center as high and low float parts, the double-float variant adds the offset to both
+			float reHi = (float)center.x;
+			float imHi = (float)center.y;
+			shader.activate();
+			centerUniform.set(glm::vec4(reHi, (float)(center.x - reHi), imHi, (float)(center.y - imHi)));
+			extentUniform.set(glm::vec2((float)(scale * aspect), (float)scale));
+			viewDirty = false;
+		}
+
+		queue.draw(shader, VAO, GL_TRIANGLES, 0, 3);
+	}
+
+	void cleanup() {
+		// shader is a copy of one of the variants
+		variants.cleanup();
+		loaded = false;
+		VAO.cleanup();
+	}
+
+	bool keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		if (key == GLFW_KEY_J && Keyboard::keyWentDown(GLFW_KEY_J)) {
+			// next preset
+			preset = (preset + 1) % (sizeof(complexPresets) / sizeof(complexPresets[0]));
+			setExpression(complexPresets[preset]);
+			return true;
+		}
+
+		if (key == GLFW_KEY_K && Keyboard::keyWentDown(GLFW_KEY_K)) {
+			setDoublePrecision(!df64);
+			return true;
+		}
+
+		if (action == GLFW_RELEASE) {
+			return false;
+		}
+
+		// pan an eighth of the view, zoom by two (repeats while held)
+		switch (key) {
+		case GLFW_KEY_LEFT: moveView(glm::dvec2(-0.25, 0.0), 1.0); return true;
+		case GLFW_KEY_RIGHT: moveView(glm::dvec2(0.25, 0.0), 1.0); return true;
+		case GLFW_KEY_UP: moveView(glm::dvec2(0.0, 0.25), 1.0); return true;
+		case GLFW_KEY_DOWN: moveView(glm::dvec2(0.0, -0.25), 1.0); return true;
+		case GLFW_KEY_EQUAL: moveView(glm::dvec2(0.0), 0.5); return true;
+		case GLFW_KEY_MINUS: moveView(glm::dvec2(0.0), 2.0); return true;
+		}
+
+		return false;
+	}
+};
+
+#endif // COMPLEXPLANE_HPP
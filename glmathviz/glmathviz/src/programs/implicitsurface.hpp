@@ -0,0 +1,231 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "program.h"
+#include "../rendering/shader.h"
+#include "../rendering/material.h"
+#include "../rendering/vertexmemory.hpp"
+#include "../math/expression.h"
+#include "../math/implicitmesher.h"
+#include "../util/threadpool.h"
+#include "../io/framescheduler.h"
+#include "../io/keyboard.h"
+
+#ifndef IMPLICITSURFACE_HPP
+#define IMPLICITSURFACE_HPP
+
+// expressions cycled through with I
+const char* const implicitPresets[] = {
+	"(sqrt(x^2 + z^2) - 1)^2 + y^2 - 0.16",
+	"sin(3*x)*cos(3*y) + sin(3*y)*cos(3*z) + sin(3*z)*cos(3*x)",
+	"x^4 - 5*x^2 + y^4 - 5*y^2 + z^4 - 5*z^2 + 11.8",
+	"x^2 + y^2 + z^2 - 1 - 0.25*sin(4*x + t)*sin(4*y)*sin(4*z)"
+};
+
+// most cells along the longest side of the box (cells, and so samples, grow with its cube)
+#define IMPLICIT_MAX_CELLS 256
+
+/*
+	level set f(x, y, z, t) = 0 over a box
+	- polygonized on the thread pool by ImplicitMesher, only bricks not meshed before are recomputed
+	- the triangles are uploaded into one VBO, re-specified on the GL thread when it outgrows its capacity
+*/
+
+class ImplicitSurface : public Program {
+	ArrayObject VAO;
+
+	glm::vec3 min;
+	glm::vec3 max;
+	float cellSize;
+
+	glm::vec3 diffuse;
+	glm::vec4 specular;
+
+	ImplicitMesher mesher;
+	// vertices drawn, vertices the VBO can hold
+	unsigned int noVertices;
+	unsigned int capacity;
+	bool meshDirty;
+	bool reallocate;
+
+	// implicit function f(x, y, z, t)
+	ExprPtr expression;
+	unsigned int preset;
+	double time;
+	bool loaded;
+
+	// smallest cell size keeping the box within IMPLICIT_MAX_CELLS per side
+	float minCellSize() {
+		glm::vec3 size = max - min;
+		return glm::max(size.x, glm::max(size.y, size.z)) / (float)IMPLICIT_MAX_CELLS;
+	}
+
+	// polygonize if the function, box or resolution changed
+	bool buildMesh() {
+		meshDirty = false;
+		if (!mesher.build(min, max, cellSize, ThreadPool::shared())) {
+			return false;
+		}
+
+		noVertices = (unsigned int)mesher.vertices.size();
+		if (noVertices > capacity) {
+			reallocate = true;
+		}
+		else if (noVertices) {
+			uploads.updateData<ImplicitVertex>(VAO["VBO"], 0, noVertices, &mesher.vertices[0]);
+		}
+		return true;
+	}
+
+public:
+	ImplicitSurface(const char* expression = implicitPresets[0],
+		glm::vec3 min = glm::vec3(-2.5f), glm::vec3 max = glm::vec3(2.5f), float cellSize = 0.05f)
+		: min(min), max(max), cellSize(glm::max(cellSize, minCellSize())),
+		diffuse(1.0f), specular(0.5f, 0.5f, 0.5f, 32.0f),
+		noVertices(0), capacity(0), meshDirty(true), reallocate(false),
+		preset(0), time(0.0), loaded(false) {
+		if (!setExpression(expression)) {
+			setExpression(implicitPresets[0]);
+		}
+	}
+
+	// parse and use a new function f(x, y, z, t), keeps the current one on a parse error
+	bool setExpression(const std::string& src) {
+		std::string error;
+		ExprPtr parsed = Expression::parse(src, error, "xyzt");
+		if (!parsed) {
+			std::cout << "Could not parse implicit surface \"" << src << "\": " << error << std::endl;
+			return false;
+		}
+
+		expression = parsed;
+		mesher.setExpression(expression);
+		mesher.setTime(time);
+		meshDirty = true;
+		return true;
+	}
+
+	// box to polygonize, bricks already meshed at the current resolution are reused
+	void setBounds(glm::vec3 min, glm::vec3 max) {
+		this->min = min;
+		this->max = max;
+		cellSize = glm::max(cellSize, minCellSize());
+		meshDirty = true;
+	}
+
+	// edge length of the cubic cells, clamped to minCellSize, false if that leaves it unchanged
+	bool setCellSize(float cellSize) {
+		cellSize = glm::max(cellSize, minCellSize());
+		if (cellSize == this->cellSize) {
+			return false;
+		}
+
+		this->cellSize = cellSize;
+		meshDirty = true;
+		return true;
+	}
+
+	void setMaterial(Material material) {
+		diffuse = material.diffuse;
+		specular = glm::vec4(material.specular, material.shininess);
+		if (loaded) {
+			shader.activate();
+			shader.set3Float("diffuse", diffuse);
+			shader.set4Float("specular", specular);
+		}
+	}
+
+	void load() {
+		loaded = true;
+		shader = Shader(false, "implicit.vert", "dirlight.frag");
+		shader.activate();
+		shader.set3Float("diffuse", diffuse);
+		shader.set4Float("specular", specular);
+
+		// first mesh sizes the buffer
+		meshDirty = false;
+		mesher.build(min, max, cellSize, ThreadPool::shared());
+		noVertices = capacity = (unsigned int)mesher.vertices.size();
+
+		VAO.generate();
+		VAO.bind();
+		VAO["VBO"] = BufferObject(GL_ARRAY_BUFFER);
+		VAO["VBO"].generate();
+		VAO["VBO"].bind();
+		VAO["VBO"].setData<ImplicitVertex>(capacity, capacity ? &mesher.vertices[0] : nullptr, GL_DYNAMIC_DRAW);
+		VAO["VBO"].setAttPointer<GLfloat>(0, 3, GL_FLOAT, 6, 0);
+		VAO["VBO"].setAttPointer<GLfloat>(1, 3, GL_FLOAT, 6, 3);
+	}
+
+	bool update(double dt) {
+		bool ret = false;
+
+		if (expression->dependsOn('t')) {
+			time += dt;
+			mesher.setTime(time);
+			meshDirty = true;
+		}
+
+		if (meshDirty) {
+			ret |= buildMesh();
+		}
+
+		return ret;
+	}
+
+	double nextUpdate() {
+		return meshDirty || expression->dependsOn('t') ? 0.0 : FrameScheduler::never;
+	}
+
+	void render(DrawQueue& queue) {
+		if (reallocate) {
+			// grow with headroom so the buffer is not re-specified on every larger mesh
+			capacity = noVertices + noVertices / 2;
+			VAO["VBO"].bind();
+			VAO["VBO"].setData<ImplicitVertex>(capacity, nullptr, GL_DYNAMIC_DRAW);
+			VAO["VBO"].updateData<ImplicitVertex>(0, noVertices, &mesher.vertices[0]);
+			reallocate = false;
+		}
+
+		if (noVertices) {
+			queue.draw(shader, VAO, GL_TRIANGLES, 0, noVertices);
+		}
+	}
+
+	void cleanup() {
+		shader.cleanup();
+		VAO.cleanup();
+		loaded = false;
+		noVertices = capacity = 0;
+		meshDirty = true;
+		reallocate = false;
+	}
+
+	bool keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		if (key == GLFW_KEY_I && Keyboard::keyWentDown(GLFW_KEY_I)) {
+			// next preset
+			preset = (preset + 1) % (sizeof(implicitPresets) / sizeof(implicitPresets[0]));
+			setExpression(implicitPresets[preset]);
+			return true;
+		}
+
+		if (key == GLFW_KEY_LEFT_BRACKET && Keyboard::keyWentDown(GLFW_KEY_LEFT_BRACKET)) {
+			// coarser
+			return setCellSize(cellSize * 2.0f);
+		}
+
+		if (key == GLFW_KEY_RIGHT_BRACKET && Keyboard::keyWentDown(GLFW_KEY_RIGHT_BRACKET)) {
+			// finer, ignored at the limit
+			return setCellSize(cellSize / 2.0f);
+		}
+
+		return false;
+	}
+};
+
+#endif // IMPLICITSURFACE_HPP
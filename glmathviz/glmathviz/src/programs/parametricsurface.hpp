@@ -0,0 +1,296 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "program.h"
+#include "../rendering/shader.h"
+#include "../rendering/material.h"
+#include "../rendering/vertexmemory.hpp"
+#include "../rendering/shadervariants.hpp"
+#include "../rendering/gridmesh.hpp"
+#include "../math/expression.h"
+#include "../io/framescheduler.h"
+#include "../io/keyboard.h"
+
+#ifndef PARAMETRICSURFACE_HPP
+#define PARAMETRICSURFACE_HPP
+
+// surface (x, y, z) = f(u, v, t) over a parameter domain
+typedef struct {
+	const char* x;
+	const char* y;
+	const char* z;
+	glm::vec4 domain; // u min, v min, u max, v max
+} ParametricPreset;
+
+// presets cycled through with V
+const ParametricPreset parametricPresets[] = {
+	{ // torus
+		"(2 + 0.75*cos(v)) * cos(u)",
+		"0.75 * sin(v)",
+		"(2 + 0.75*cos(v)) * sin(u)",
+		glm::vec4(0.0f, 0.0f, glm::two_pi<float>(), glm::two_pi<float>())
+	},
+	{ // Mobius strip
+		"(2 + v/2*cos(u/2)) * cos(u)",
+		"v/2 * sin(u/2)",
+		"(2 + v/2*cos(u/2)) * sin(u)",
+		glm::vec4(0.0f, -1.0f, glm::two_pi<float>(), 1.0f)
+	},
+	{ // figure-8 Klein bottle
+		"(2 + cos(u/2)*sin(v) - sin(u/2)*sin(2*v)) * cos(u)",
+		"sin(u/2)*sin(v) + cos(u/2)*sin(2*v)",
+		"(2 + cos(u/2)*sin(v) - sin(u/2)*sin(2*v)) * sin(u)",
+		glm::vec4(0.0f, 0.0f, glm::two_pi<float>(), glm::two_pi<float>())
+	},
+	{ // torus with a travelling wave
+		"(2 + (0.75 + 0.15*sin(3*u + t))*cos(v)) * cos(u)",
+		"(0.75 + 0.15*sin(3*u + t)) * sin(v)",
+		"(2 + (0.75 + 0.15*sin(3*u + t))*cos(v)) * sin(u)",
+		glm::vec4(0.0f, 0.0f, glm::two_pi<float>(), glm::two_pi<float>())
+	}
+};
+
+/*
+	instanced parametric patches evaluated in parametric.vert
+	- each instance covers its own rectangle of the (u, v) domain, offset in world space
+	- one shared grid mesh of u_cells x v_cells, every instance drawn in one call
+*/
+
+class ParametricSurface : public Program {
+	ArrayObject VAO;
+	int u_cells;
+	int v_cells;
+
+	GridMesh* grid;
+
+	unsigned int noInstances;
+	unsigned int maxNoInstances;
+	std::vector<glm::vec4> bounds;
+	std::vector<glm::vec3> diffuse;
+	std::vector<glm::vec4> specular;
+	std::vector<glm::vec3> offsets;
+
+	// surface components x, y, z = f(u, v, t)
+	ExprPtr components[3];
+	unsigned int preset;
+	double time;
+
+	// compiled programs by hash of the generated source
+	ShaderVariants variants;
+	bool loaded;
+
+	UniformHandle<float> timeUniform;
+
+	bool dependsOnTime() {
+		return components[0]->dependsOn('t') || components[1]->dependsOn('t') || components[2]->dependsOn('t');
+	}
+
+	// GLSL vector of the components, or their partial derivatives with respect to variable
+	std::string componentsGLSL(char variable = 0) {
+		std::string ret = "vec3(";
+		for (int i = 0; i < 3; i++) {
+			ret += (variable ? components[i]->derivative(variable) : components[i])->toGLSL();
+			ret += i < 2 ? ", " : ")";
+		}
+		return ret;
+	}
+
+	// GLSL defining param and its symbolic partial derivatives paramDu, paramDv
+	std::string generateSource() {
+		return "#version 330 core\n"
+			"uniform float time;\n"
+			+ Expression::glslPrelude() +
+			"vec3 param(float u, float v) {\n"
+			"	return " + componentsGLSL() + ";\n"
+			"}\n"
+			"vec3 paramDu(float u, float v) {\n"
+			"	return " + componentsGLSL('u') + ";\n"
+			"}\n"
+			"vec3 paramDv(float u, float v) {\n"
+			"	return " + componentsGLSL('v') + ";\n"
+			"}\n";
+	}
+
+	// switch to the variant for the current components, compiling it on first use
+	void useVariant() {
+		std::string src = generateSource();
+		unsigned long long key = Expression::hash(src);
+
+		Shader* variant = variants.find(key, src);
+		if (!variant) {
+			Shader compiled;
+			compiled.generate(false, "parametric.vert", "dirlight.frag", nullptr, GL_VERTEX_SHADER, src);
+			compiled.activate();
+			compiled.setInt("u_cells", u_cells);
+			compiled.setInt("v_cells", v_cells);
+			compiled.setBool("twoSided", true);
+			variant = variants.add(key, src, compiled);
+		}
+
+		// uniforms are per program, restore the current state
+		shader = *variant;
+		shader.activate();
+		timeUniform = shader.getUniform<float>("time");
+		timeUniform.set((float)time);
+	}
+
+public:
+	ParametricSurface(unsigned int maxNoInstances, int u_cells, int v_cells, unsigned int preset = 0)
+		: u_cells(u_cells), v_cells(v_cells), grid(nullptr),
+		noInstances(0), maxNoInstances(maxNoInstances),
+		preset(0), time(0.0), loaded(false) {
+		if (preset >= sizeof(parametricPresets) / sizeof(parametricPresets[0]) || !setPreset(preset)) {
+			setPreset(0);
+		}
+	}
+
+	// parse and use new components f(u, v, t), keeps the current ones on a parse error
+	bool setExpression(const std::string& x, const std::string& y, const std::string& z) {
+		const std::string* src[3] = { &x, &y, &z };
+		ExprPtr parsed[3];
+		for (int i = 0; i < 3; i++) {
+			std::string error;
+			parsed[i] = Expression::parse(*src[i], error, "uvt");
+			if (!parsed[i]) {
+				std::cout << "Could not parse parametric surface component \"" << *src[i] << "\": " << error << std::endl;
+				return false;
+			}
+		}
+
+		for (int i = 0; i < 3; i++) {
+			components[i] = parsed[i];
+		}
+		if (loaded) {
+			useVariant();
+		}
+		return true;
+	}
+
+	// use a preset, instance bounds are mapped from the domain of the current one to the new one
+	bool setPreset(unsigned int newPreset) {
+		const ParametricPreset& next = parametricPresets[newPreset];
+		if (!setExpression(next.x, next.y, next.z)) {
+			return false;
+		}
+
+		glm::vec4 from = parametricPresets[preset].domain;
+		glm::vec4 to = next.domain;
+		for (glm::vec4& b : bounds) {
+			glm::vec4 rel = (b - glm::vec4(from.x, from.y, from.x, from.y))
+				/ glm::vec4(from.z - from.x, from.w - from.y, from.z - from.x, from.w - from.y);
+			b = glm::vec4(to.x, to.y, to.x, to.y) + rel * glm::vec4(to.z - to.x, to.w - to.y, to.z - to.x, to.w - to.y);
+		}
+		if (loaded && noInstances) {
+			uploads.updateData<glm::vec4>(VAO["boundsVBO"], 0, noInstances, &bounds[0]);
+		}
+
+		preset = newPreset;
+		return true;
+	}
+
+	// parameter domain of the current preset
+	glm::vec4 domain() {
+		return parametricPresets[preset].domain;
+	}
+
+	// patch over [start, end] of the (u, v) domain, translated by offset
+	bool addInstance(glm::vec2 start, glm::vec2 end, Material material, glm::vec3 offset = glm::vec3(0.0f)) {
+		if (noInstances >= maxNoInstances) {
+			return false;
+		}
+
+		bounds.push_back(glm::vec4(start, end));
+		diffuse.push_back(material.diffuse);
+		specular.push_back(glm::vec4(material.specular, material.shininess));
+		offsets.push_back(offset);
+
+		noInstances++;
+		return true;
+	}
+
+	void load() {
+		loaded = true;
+		useVariant();
+
+		VAO.generate();
+		VAO.bind();
+
+		if (noInstances) {
+			VAO["boundsVBO"] = BufferObject(GL_ARRAY_BUFFER);
+			VAO["boundsVBO"].generate();
+			VAO["boundsVBO"].bind();
+			VAO["boundsVBO"].setData<glm::vec4>(noInstances, &bounds[0], GL_DYNAMIC_DRAW);
+			VAO["boundsVBO"].setAttPointer<GLfloat>(0, 4, GL_FLOAT, 4, 0, 1);
+
+			VAO["diffuseVBO"] = BufferObject(GL_ARRAY_BUFFER);
+			VAO["diffuseVBO"].generate();
+			VAO["diffuseVBO"].bind();
+			VAO["diffuseVBO"].setData<glm::vec3>(noInstances, &diffuse[0], GL_STATIC_DRAW);
+			VAO["diffuseVBO"].setAttPointer<GLfloat>(1, 3, GL_FLOAT, 3, 0, 1);
+
+			VAO["specularVBO"] = BufferObject(GL_ARRAY_BUFFER);
+			VAO["specularVBO"].generate();
+			VAO["specularVBO"].bind();
+			VAO["specularVBO"].setData<glm::vec4>(noInstances, &specular[0], GL_STATIC_DRAW);
+			VAO["specularVBO"].setAttPointer<GLfloat>(2, 4, GL_FLOAT, 4, 0, 1);
+
+			VAO["offsetVBO"] = BufferObject(GL_ARRAY_BUFFER);
+			VAO["offsetVBO"].generate();
+			VAO["offsetVBO"].bind();
+			VAO["offsetVBO"].setData<glm::vec3>(noInstances, &offsets[0], GL_STATIC_DRAW);
+			VAO["offsetVBO"].setAttPointer<GLfloat>(3, 3, GL_FLOAT, 3, 0, 1);
+		}
+
+		grid = GridMesh::acquire(u_cells, v_cells);
+	}
+
+	bool update(double dt) {
+		if (dependsOnTime()) {
+			time += dt;
+			uploads.setUniform<float>(shader, timeUniform, (float)time);
+			return true;
+		}
+
+		return false;
+	}
+
+	double nextUpdate() {
+		return dependsOnTime() ? 0.0 : FrameScheduler::never;
+	}
+
+	void render(DrawQueue& queue) {
+		queue.draw(shader, VAO, GL_TRIANGLE_STRIP, grid->noIndices, GL_UNSIGNED_INT, 0, noInstances);
+	}
+
+	void cleanup() {
+		// shader is a copy of one of the variants
+		variants.cleanup();
+		loaded = false;
+		VAO.cleanup();
+		GridMesh::release(grid);
+		grid = nullptr;
+		bounds.clear();
+		diffuse.clear();
+		specular.clear();
+		offsets.clear();
+		noInstances = 0;
+	}
+
+	bool keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		if (key == GLFW_KEY_V && Keyboard::keyWentDown(GLFW_KEY_V)) {
+			// next preset
+			setPreset((preset + 1) % (sizeof(parametricPresets) / sizeof(parametricPresets[0])));
+			return true;
+		}
+
+		return false;
+	}
+};
+
+#endif // PARAMETRICSURFACE_HPP
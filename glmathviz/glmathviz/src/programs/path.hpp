@@ -28,6 +28,7 @@ public:
 	Path(Transition<glm::vec3> *path, unsigned int resolution = 100)
 		: path(path),
 		maxPoints(resolution + 1), // +1 because resolution is for line segments
+		stopwatch(0.0),
 		stopwatchIncrement(path->getDuration() / (double)resolution)
 	{}
 
@@ -51,9 +52,8 @@ public:
 			stopwatch += dt;
 			if (stopwatch >= stopwatchIncrement) {
 				points.push_back(path->getCurrent());
-				VAO.bind();
-				VAO["VBO"].bind();
-				VAO["VBO"].updateData<glm::vec3>(0, (GLuint)points.size(), &points[0]);
+				// only the new point has to be uploaded
+				uploads.updateData<glm::vec3>(VAO["VBO"], (points.size() - 1) * sizeof(glm::vec3), 1, &points.back());
 
 				stopwatch = 0.0;
 				return true;
@@ -63,10 +63,17 @@ public:
 		return false;
 	}
 
-	void render() {
-		shader.activate();
-		VAO.bind();
-		VAO.draw(GL_LINE_STRIP, 0, (GLuint)points.size());
+	double nextUpdate() {
+		if (path->isRunning() && points.size() < maxPoints) {
+			// next point is due once the stopwatch passes the increment
+			return stopwatchIncrement - stopwatch;
+		}
+
+		return FrameScheduler::never;
+	}
+
+	void render(DrawQueue& queue) {
+		queue.draw(shader, VAO, GL_LINE_STRIP, 0, (GLuint)points.size());
 	}
 
 	void cleanup() {
@@ -1,14 +1,11 @@
 #include "program.h"
 
-void Program::updateCameraMatrices(glm::mat4 projView, glm::vec3 camPos) {
-	shader.activate();
-	shader.setMat4("projView", projView);
-	shader.set3Float("viewPos", camPos);
-}
-
 void Program::load() {}
 bool Program::update(double dt) { return false; }
-void Program::render() {}
+double Program::nextUpdate() { return FrameScheduler::never; }
+void Program::render(DrawQueue& queue) {}
+void Program::cameraChanged(glm::mat4 projView, glm::vec3 viewPos) {}
+void Program::viewportChanged(int width, int height) {}
 void Program::cleanup() {}
 
 bool Program::processInput(double dt, GLFWwindow* window) { return false; }
@@ -1,7 +1,11 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 
 #include "../rendering/shader.h"
+#include "../rendering/drawqueue.hpp"
+#include "../rendering/uploadlist.hpp"
+#include "../io/framescheduler.h"
 
 #ifndef PROGRAM_H
 #define PROGRAM_H
@@ -10,10 +14,18 @@ class Program {
 public:
 	Shader shader;
 
-	void updateCameraMatrices(glm::mat4 projView, glm::vec3 camPos);
+	// GPU writes recorded by update (may run off the GL thread), replayed before render
+	UploadList uploads;
+
 	virtual void load();
 	virtual bool update(double dt);
-	virtual void render();
+	// seconds until update next needs to run (FrameScheduler::never if static)
+	virtual double nextUpdate();
+	virtual void render(DrawQueue& queue);
+	// camera written for the next frames (GL thread, between updates)
+	virtual void cameraChanged(glm::mat4 projView, glm::vec3 viewPos);
+	// framebuffer size for the next frames (GL thread, at load and on resize)
+	virtual void viewportChanged(int width, int height);
 	virtual void cleanup();
 
 	virtual bool processInput(double dt, GLFWwindow* window);
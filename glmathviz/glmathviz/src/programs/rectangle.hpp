@@ -35,10 +35,8 @@ public:
 		VAO["VBO"].setAttPointer<GLfloat>(0, 3, GL_FLOAT, 3, 0);
 	}
 
-	void render() {
-		shader.activate();
-		VAO.bind();
-		VAO.draw(GL_TRIANGLES, 0, 6);
+	void render(DrawQueue& queue) {
+		queue.draw(shader, VAO, GL_TRIANGLES, 0, 6);
 	}
 
 	void cleanup() {
@@ -154,18 +154,19 @@ public:
 	bool update(double dt) {
 		if (noInstances && path->isRunning()) {
 			offsets[0] = path->getCurrent();
-			VAO["offsetVBO"].bind();
-			VAO["offsetVBO"].updateData<glm::vec3>(0, noInstances, &offsets[0]);
+			uploads.updateData<glm::vec3>(VAO["offsetVBO"], 0, 1, &offsets[0]);
 			return true;
 		}
 
 		return false;
 	}
 
-	void render() {
-		shader.activate();
-		VAO.bind();
-		VAO.draw(GL_TRIANGLES, (GLuint)indices.size(), GL_UNSIGNED_INT, 0, noInstances);
+	double nextUpdate() {
+		return noInstances ? path->nextChange() : FrameScheduler::never;
+	}
+
+	void render(DrawQueue& queue) {
+		queue.draw(shader, VAO, GL_TRIANGLES, (GLuint)indices.size(), GL_UNSIGNED_INT, 0, noInstances);
 	}
 
 	void cleanup() {
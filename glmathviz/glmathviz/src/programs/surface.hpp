@@ -3,24 +3,123 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <string>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <iostream>
 
 #include "program.h"
 #include "../rendering/shader.h"
 #include "../rendering/material.h"
 #include "../rendering/vertexmemory.hpp"
 #include "../rendering/transition.hpp"
+#include "../rendering/shadervariants.hpp"
+#include "../rendering/gridmesh.hpp"
+#include "../rendering/feedbackcapture.hpp"
+#include "../rendering/heightfield.hpp"
+#include "../math/expression.h"
+#include "../math/surfaceevaluator.h"
+#include "../math/surfacequadtree.h"
+#include "../math/surfaceclipmap.h"
+#include "../math/frustum.h"
+#include "../math/contourextractor.h"
+#include "../util/threadpool.h"
 #include "../io/keyboard.h"
 
 #ifndef SURFACE_HPP
 #define SURFACE_HPP
 
+// expressions cycled through with F
+const char* const surfacePresets[] = {
+	"1 / (x*x + z*z)",
+	"cos(x) * sin(z)",
+	"3 * sin((x*x + z*z) / 4) / ((x*x + z*z) / 4)",
+	"floor(exp(abs(x*z/2)) + round(1/cos(x*z)))", // normal only visible with the cross product
+	"(sign(-0.65 - x) + sign(-0.35 - x) + sign(-0.5 - x) + sign(0.25 - x) + sign(0.55 - x)) / 7",
+	"1 - abs(x + z) - abs(z - x)",
+	"sin(x + t) * cos(z - t / 2)"
+};
+
+// how the surface is tessellated
+enum class SurfaceMode {
+	GEOMETRY,	// one point per cell, expanded to a quad in surface.geom (culled in chunks)
+	GRID,		// shared indexed grid displaced in surface_grid.vert (culled in chunks)
+	CAPTURED,	// surface.geom output captured once per change, then drawn as plain triangles
+	CPU,		// heights and normals evaluated on the thread pool, read from a texture buffer in surface_cpu.vert
+	ADAPTIVE,	// quadtree of surface_grid.vert patches refined by projected error (see SurfaceQuadtree)
+	CLIPMAP,	// rings of surface_grid.vert patches around the camera, coarser farther out (see SurfaceClipmap)
+	TEXTURE		// heights and normals baked into a texture on change, read in surface_texture.vert (see HeightField)
+};
+
+// cells per side of an adaptive or clipmap patch
+#define SURFACE_PATCH_CELLS 8
+// cells per side of a GEOMETRY or GRID chunk
+#define SURFACE_CHUNK_CELLS 50
+// samples per side for the y range of a patch
+#define SURFACE_RANGE_SAMPLES 5
+// levels toggled with L
+#define SURFACE_CONTOUR_LEVELS 10
+
+// instance data of one patch
+typedef struct {
+	glm::vec4 bounds; // of the instance
+	glm::vec3 diffuse;
+	glm::vec4 specular;
+	glm::vec4 lattice; // first vertex on the finest lattice (x, z), lattice steps per cell, stitch flags
+	glm::vec2 latticeCells; // finest lattice cells across the instance
+} SurfacePatch;
+
 class Surface : public Program {
 	ArrayObject VAO;
 	int x_cells;
 	int z_cells;
 
+	SurfaceMode mode;
+	GridMesh* grid;
+	FeedbackCapture capture;
+
+	// CPU mode: (y, normal.x, normal.z, 0) per vertex, one grid after another per instance
+	SurfaceEvaluator evaluator;
+	std::vector<glm::vec4> heights;
+	BufferObject heightsBuffer;
+	GLuint heightsTexture;
+	bool heightsDirty;
+
+	// TEXTURE mode: shader is the draw program, bakeShader the variant evaluating the function
+	HeightField heightField;
+	Shader bakeShader;
+
+	// patches (chunks, quadtree leaves or rings), rebuilt and culled when the camera or function changes
+	std::vector<QuadLeaf> chunks;
+	SurfaceQuadtree quadtree;
+	SurfaceClipmap clipmap;
+	std::vector<SurfacePatch> patches;
+	unsigned int noPatches;
+	bool patchesDirty;
+
+	// y range of every patch for culling, sampled when the patches or function change
+	Frustum frustum;
+	std::vector<glm::vec2> ranges;
+	bool rangesDirty;
+
 	bool calculus;
 
+	// contour lines: heights re-evaluated when the function changes, lines re-extracted when the levels change
+	ContourExtractor contours;
+	std::vector<float> contourLevels;
+	int contourCells; // per side, 0 for x_cells by z_cells
+	std::vector<std::vector<float>> contourHeights; // per instance
+	bool contourHeightsDirty;
+	bool contourLinesDirty;
+	ArrayObject contourVAO;
+	Shader contourShader;
+	std::vector<GLuint> contourIndices; // line strips separated by GRID_RESTART_INDEX
+	unsigned int noContourIndices;
+	unsigned int contourVertexCapacity;
+	unsigned int contourIndexCapacity;
+	bool contourReallocate;
+
 	unsigned int noInstances;
 	unsigned int maxNoInstances;
 	std::vector<glm::vec4> bounds;
@@ -29,12 +128,328 @@ class Surface : public Program {
 
 	CubicBezierTransition<double> transition;
 
+	// surface function y = f(x, z, t)
+	ExprPtr expression;
+	unsigned int preset;
+	double time;
+
+	// compiled programs by hash of the generated source
+	ShaderVariants variants;
+	bool loaded;
+
+	UniformHandle<bool> calculusUniform;
+	UniformHandle<float> xOffsetUniform;
+	UniformHandle<float> timeUniform;
+
+	// GLSL defining func and funcNorm (normal from the symbolic partial derivatives)
+	std::string generateSource() {
+		ExprPtr normX = Expression::neg(expression->derivative('x'));
+		ExprPtr normZ = Expression::neg(expression->derivative('z'));
+
+		return "#version 330 core\n"
+			"uniform float x_offset;\n"
+			"uniform float time;\n"
+			+ Expression::glslPrelude() +
+			"float func(float x, float z) {\n"
+			"	x -= x_offset;\n"
+			"	return " + expression->toGLSL() + ";\n"
+			"}\n"
+			"vec3 funcNorm(vec3 p) {\n"
+			"	float x = p.x - x_offset;\n"
+			"	float z = p.z;\n"
+			"	return vec3(" + normX->toGLSL() + ", 1.0, " + normZ->toGLSL() + ");\n"
+			"}\n";
+	}
+
+	// switch to the variant for the current expression, compiling it on first use
+	void useVariant() {
+		std::string src = generateSource();
+		unsigned long long key = Expression::hash(src);
+
+		Shader* variant = variants.find(key, src);
+		if (!variant) {
+			Shader compiled;
+			if (mode == SurfaceMode::TEXTURE) {
+				compiled.generate(false, "surface_bake.vert", "surface_bake.frag", nullptr, GL_FRAGMENT_SHADER, src);
+			}
+			else if (mode == SurfaceMode::GRID || mode == SurfaceMode::ADAPTIVE || mode == SurfaceMode::CLIPMAP) {
+				compiled.generate(false, "surface_grid.vert", "dirlight.frag", nullptr, GL_VERTEX_SHADER, src);
+			}
+			else {
+				if (mode == SurfaceMode::CAPTURED) {
+					FeedbackCapture::prepareShader(compiled);
+				}
+				compiled.generate(false, "surface.vert", "dirlight.frag", "surface.geom", GL_GEOMETRY_SHADER, src);
+			}
+			compiled.activate();
+			compiled.setInt("x_cells", usesPatches() ? patchCells() : x_cells);
+			compiled.setInt("z_cells", usesPatches() ? patchCells() : z_cells);
+			variant = variants.add(key, src, compiled);
+		}
+
+		// uniforms are per program, restore the current state
+		functionShader() = *variant;
+		bindUniforms();
+	}
+
+	// program evaluating the function (holds the calculus, x_offset and time uniforms)
+	Shader& functionShader() {
+		return mode == SurfaceMode::TEXTURE ? bakeShader : shader;
+	}
+
+	// get handles and restore the current uniform state
+	void bindUniforms() {
+		Shader& target = functionShader();
+		target.activate();
+		calculusUniform = target.getUniform<bool>("calculus");
+		xOffsetUniform = target.getUniform<float>("x_offset");
+		timeUniform = target.getUniform<float>("time");
+		calculusUniform.set(calculus);
+		xOffsetUniform.set((float)transition.getCurrent());
+		timeUniform.set((float)time);
+		capture.dirty = true;
+		heightsDirty = true;
+		heightField.dirty = true;
+	}
+
+	// evaluate every instance's grid into heights
+	void evaluateHeights() {
+		unsigned int verticesPerInstance = (x_cells + 1) * (z_cells + 1);
+		for (unsigned int i = 0; i < noInstances; i++) {
+			evaluator.evaluate(bounds[i], x_cells, z_cells, transition.getCurrent(), time,
+				calculus, &heights[i * verticesPerInstance], ThreadPool::shared());
+		}
+		heightsDirty = false;
+	}
+
+	// drawn as instanced patches, culled against the camera
+	bool usesPatches() {
+		return mode == SurfaceMode::GEOMETRY || mode == SurfaceMode::GRID
+			|| mode == SurfaceMode::ADAPTIVE || mode == SurfaceMode::CLIPMAP;
+	}
+
+	// cells per patch side
+	int patchCells() {
+		return mode == SurfaceMode::GEOMETRY || mode == SurfaceMode::GRID
+			? SURFACE_CHUNK_CELLS : SURFACE_PATCH_CELLS;
+	}
+
+	// split the instances into fixed chunks (GEOMETRY and GRID)
+	void generateChunks() {
+		chunks.clear();
+		for (unsigned int instance = 0; instance < noInstances; instance++) {
+			glm::vec4 b = bounds[instance];
+			glm::vec2 cell((b.z - b.x) / x_cells, (b.w - b.y) / z_cells);
+			for (int i = 0; i * SURFACE_CHUNK_CELLS < x_cells; i++) {
+				for (int j = 0; j * SURFACE_CHUNK_CELLS < z_cells; j++) {
+					glm::vec4 chunkBounds(
+						b.x + i * SURFACE_CHUNK_CELLS * cell.x,
+						b.y + j * SURFACE_CHUNK_CELLS * cell.y,
+						(i + 1) * SURFACE_CHUNK_CELLS < x_cells ? b.x + (i + 1) * SURFACE_CHUNK_CELLS * cell.x : b.z,
+						(j + 1) * SURFACE_CHUNK_CELLS < z_cells ? b.y + (j + 1) * SURFACE_CHUNK_CELLS * cell.y : b.w
+					);
+					chunks.push_back({ instance, 0, i, j, chunkBounds, 0 });
+				}
+			}
+		}
+		rangesDirty = true;
+	}
+
+	// rebuild the quadtree or rings, then record the visible patches if they changed
+	bool buildPatches() {
+		patchesDirty = false;
+		std::vector<QuadLeaf>* leaves = &chunks;
+		if (mode == SurfaceMode::ADAPTIVE) {
+			quadtree.setFunctionState(transition.getCurrent(), time);
+			rangesDirty |= quadtree.build(bounds);
+			leaves = &quadtree.leaves;
+		}
+		else if (mode == SurfaceMode::CLIPMAP) {
+			clipmap.setFunctionState(transition.getCurrent(), time);
+			rangesDirty |= clipmap.build(bounds);
+			leaves = &clipmap.chunks;
+		}
+
+		// conservative y range of every patch
+		if (rangesDirty) {
+			ranges.resize(leaves->size());
+			double xOffset = transition.getCurrent();
+			ThreadPool::shared().parallelFor((unsigned int)leaves->size(), [this, leaves, xOffset](unsigned int i) {
+				ranges[i] = evaluator.sampleRange((*leaves)[i].bounds, SURFACE_RANGE_SAMPLES, xOffset, time);
+			});
+			rangesDirty = false;
+		}
+
+		bool changed = false;
+		unsigned int noVisible = 0;
+		for (unsigned int i = 0; i < leaves->size() && noVisible < patches.size(); i++) {
+			QuadLeaf& leaf = (*leaves)[i];
+			if (!frustum.intersects(glm::vec3(leaf.bounds.x, ranges[i].x, leaf.bounds.y),
+				glm::vec3(leaf.bounds.z, ranges[i].y, leaf.bounds.w))) {
+				continue;
+			}
+
+			// quadtree levels refine towards the lattice, clipmap levels coarsen away from it
+			int step = 1;
+			glm::vec2 latticeCells((float)x_cells, (float)z_cells);
+			if (mode == SurfaceMode::ADAPTIVE) {
+				assert(leaf.level <= quadtree.maxDepth);
+				step = 1 << (quadtree.maxDepth - leaf.level);
+				latticeCells = glm::vec2((float)(SURFACE_PATCH_CELLS << quadtree.maxDepth));
+			}
+			else if (mode == SurfaceMode::CLIPMAP) {
+				step = 1 << leaf.level;
+				latticeCells = glm::vec2(clipmap.latticeCells(bounds[leaf.instance]));
+			}
+
+			glm::vec4 lattice(
+				(float)(leaf.i * patchCells() * step),
+				(float)(leaf.j * patchCells() * step),
+				(float)step, (float)leaf.stitch);
+			SurfacePatch patch = { bounds[leaf.instance], diffuse[leaf.instance], specular[leaf.instance], lattice, latticeCells };
+			changed |= noVisible >= noPatches || memcmp(&patches[noVisible], &patch, sizeof(SurfacePatch)) != 0;
+			patches[noVisible++] = patch;
+		}
+
+		changed |= noVisible != noPatches;
+		noPatches = noVisible;
+		if (changed && noPatches) {
+			uploads.updateData<SurfacePatch>(VAO["patchVBO"], 0, noPatches, &patches[0]);
+		}
+		return changed;
+	}
+
+	// contour grid cells per side
+	glm::ivec2 contourResolution() {
+		return contourCells > 0 ? glm::ivec2(contourCells) : glm::ivec2(x_cells, z_cells);
+	}
+
+	// marching squares over every instance at the current levels, evaluating the heights first if they changed
+	bool buildContours() {
+		glm::ivec2 cells = contourResolution();
+		if (contourHeightsDirty && !contourLevels.empty()) {
+			contourHeights.resize(noInstances);
+			for (unsigned int i = 0; i < noInstances; i++) {
+				contourHeights[i].resize((cells.x + 1) * (cells.y + 1));
+				evaluator.evaluateHeights(bounds[i], cells.x, cells.y, transition.getCurrent(), time,
+					&contourHeights[i][0], ThreadPool::shared());
+			}
+			contourHeightsDirty = false;
+		}
+
+		contours.clear();
+		if (!contourLevels.empty()) {
+			for (unsigned int i = 0; i < noInstances; i++) {
+				contours.extract(&contourHeights[i][0], bounds[i], cells.x, cells.y, contourLevels, ThreadPool::shared());
+			}
+		}
+		contourLinesDirty = false;
+
+		contourIndices.clear();
+		for (ContourLine& line : contours.lines) {
+			for (unsigned int i = 0; i < line.count; i++) {
+				contourIndices.push_back(line.first + i);
+			}
+			contourIndices.push_back(GRID_RESTART_INDEX);
+		}
+
+		unsigned int noVertices = (unsigned int)contours.vertices.size();
+		noContourIndices = (unsigned int)contourIndices.size();
+		if (noVertices > contourVertexCapacity || noContourIndices > contourIndexCapacity) {
+			contourReallocate = true;
+		}
+		else if (noContourIndices) {
+			uploads.updateData<glm::vec3>(contourVAO["VBO"], 0, noVertices, &contours.vertices[0]);
+			uploads.updateData<GLuint>(contourVAO["EBO"], 0, noContourIndices, &contourIndices[0]);
+		}
+		return true;
+	}
+
+	// evenly spaced levels inside the sampled y range of the instances
+	std::vector<float> defaultContourLevels() {
+		glm::vec2 range(INFINITY, -INFINITY);
+		for (unsigned int i = 0; i < noInstances; i++) {
+			glm::vec2 r = evaluator.sampleRange(bounds[i], 2 * SURFACE_RANGE_SAMPLES, transition.getCurrent(), time);
+			range = glm::vec2(glm::min(range.x, r.x), glm::max(range.y, r.y));
+		}
+		if (!isfinite(range.x) || !isfinite(range.y) || range.x >= range.y) {
+			range = glm::vec2(-1.0f, 1.0f);
+		}
+
+		std::vector<float> ret(SURFACE_CONTOUR_LEVELS);
+		float step = (range.y - range.x) / (float)(SURFACE_CONTOUR_LEVELS + 1);
+		for (int i = 0; i < SURFACE_CONTOUR_LEVELS; i++) {
+			ret[i] = range.x + (i + 1) * step;
+		}
+		return ret;
+	}
+
 public:
-	Surface(unsigned int maxNoInstances, int x_cells, int z_cells)
+	Surface(unsigned int maxNoInstances, int x_cells, int z_cells,
+		const char* expression = surfacePresets[0], SurfaceMode mode = SurfaceMode::GEOMETRY)
 		: noInstances(0), maxNoInstances(maxNoInstances), 
 		x_cells(x_cells), z_cells(z_cells),
+		mode(mode), grid(nullptr),
+		heightsBuffer(GL_TEXTURE_BUFFER), heightsTexture(0), heightsDirty(true),
+		quadtree(SURFACE_PATCH_CELLS), clipmap(SURFACE_PATCH_CELLS), noPatches(0), patchesDirty(true), rangesDirty(true),
 		calculus(true),
-		transition(CubicBezierTransition<double>::newEaseTransition(0.0, 3.0, 5.0)) {}
+		contourCells(0), contourHeightsDirty(true), contourLinesDirty(false),
+		noContourIndices(0), contourVertexCapacity(0), contourIndexCapacity(0), contourReallocate(false),
+		transition(CubicBezierTransition<double>::newEaseTransition(0.0, 3.0, 5.0)),
+		preset(0), time(0.0), loaded(false) {
+		if (!setExpression(expression)) {
+			setExpression(surfacePresets[0]);
+		}
+
+		// finest patches match the resolution of the uniform grid
+		int cells = x_cells > z_cells ? x_cells : z_cells;
+		int depth = 0;
+		while ((SURFACE_PATCH_CELLS << depth) < cells) {
+			depth++;
+		}
+		quadtree.setMaxDepth(depth);
+	}
+
+	// parse and use a new surface function f(x, z, t), keeps the current one on a parse error
+	bool setExpression(const std::string& src) {
+		std::string error;
+		ExprPtr parsed = Expression::parse(src, error);
+		if (!parsed) {
+			std::cout << "Could not parse surface \"" << src << "\": " << error << std::endl;
+			return false;
+		}
+
+		expression = parsed;
+		evaluator.setExpression(expression);
+		quadtree.setExpression(expression);
+		clipmap.setExpression(expression);
+		heightsDirty = true;
+		patchesDirty = true;
+		rangesDirty = true;
+		contourHeightsDirty = true;
+		contourLinesDirty = !contourLevels.empty();
+		if (loaded && mode != SurfaceMode::CPU) {
+			useVariant();
+		}
+		return true;
+	}
+
+	// finest cell size of the clipmap (world units)
+	void setClipmapCellSize(float cellSize) {
+		clipmap.cellSize = cellSize;
+		patchesDirty = true;
+	}
+
+	// draw contour lines at levels (none to hide them), extracted from a cells x cells grid per instance
+	// - 0 cells uses the surface resolution, moving the levels does not re-evaluate the function
+	void setContours(const std::vector<float>& levels, int cells = 0) {
+		contourLevels = levels;
+		if (cells != contourCells) {
+			contourCells = cells;
+			contourHeightsDirty = true;
+		}
+		contourLinesDirty = true;
+	}
 
 	bool addInstance(glm::vec2 start, glm::vec2 end, Material material) {
 		if (noInstances >= maxNoInstances) {
@@ -50,17 +465,56 @@ public:
 	}
 
 	void load() {
-		shader = Shader(false, "surface.vert", "dirlight.frag", "surface.geom");
-		shader.activate();
-		shader.setInt("x_cells", x_cells);
-		shader.setInt("z_cells", z_cells);
-		shader.setBool("calculus", calculus);
-		shader.setFloat("x_offset", 0.0f);
+		loaded = true;
+		if (mode == SurfaceMode::CPU) {
+			// nothing generated, the function is evaluated on the CPU
+			shader.generate(false, "surface_cpu.vert", "dirlight.frag", nullptr);
+			shader.activate();
+			shader.setInt("x_cells", x_cells);
+			shader.setInt("z_cells", z_cells);
+			shader.setInt("heights", 0);
+			bindUniforms();
+		}
+		else if (mode == SurfaceMode::TEXTURE) {
+			// draw program reads the baked texture, the function is in the bake variants
+			shader.generate(false, "surface_texture.vert", "dirlight.frag", nullptr);
+			shader.activate();
+			shader.setInt("x_cells", x_cells);
+			shader.setInt("z_cells", z_cells);
+			shader.setInt("heightField", 0);
+			useVariant();
+		}
+		else {
+			useVariant();
+		}
 
 		VAO.generate();
 		VAO.bind();
 
-		if (noInstances) {
+		if (noInstances && usesPatches()) {
+			// room for every chunk, every instance at the finest level, or every ring
+			if (mode == SurfaceMode::ADAPTIVE) {
+				patches.resize(noInstances << (2 * quadtree.maxDepth));
+			}
+			else if (mode == SurfaceMode::CLIPMAP) {
+				patches.resize(noInstances * CLIPMAP_MAX_LEVELS * 4 * CLIPMAP_RING_CHUNKS * CLIPMAP_RING_CHUNKS);
+			}
+			else {
+				generateChunks();
+				patches.resize(chunks.size());
+			}
+
+			VAO["patchVBO"] = BufferObject(GL_ARRAY_BUFFER);
+			VAO["patchVBO"].generate();
+			VAO["patchVBO"].bind();
+			VAO["patchVBO"].setData<SurfacePatch>((GLuint)patches.size(), nullptr, GL_DYNAMIC_DRAW);
+			VAO["patchVBO"].setAttPointer<GLfloat>(0, 4, GL_FLOAT, 17, 0, 1);
+			VAO["patchVBO"].setAttPointer<GLfloat>(1, 3, GL_FLOAT, 17, 4, 1);
+			VAO["patchVBO"].setAttPointer<GLfloat>(2, 4, GL_FLOAT, 17, 7, 1);
+			VAO["patchVBO"].setAttPointer<GLfloat>(3, 4, GL_FLOAT, 17, 11, 1);
+			VAO["patchVBO"].setAttPointer<GLfloat>(4, 2, GL_FLOAT, 17, 15, 1);
+		}
+		else if (noInstances) {
 			VAO["boundsVBO"] = BufferObject(GL_ARRAY_BUFFER);
 			VAO["boundsVBO"].generate();
 			VAO["boundsVBO"].bind();
@@ -79,28 +533,205 @@ public:
 			VAO["specularVBO"].setData<glm::vec4>(noInstances, &specular[0], GL_STATIC_DRAW);
 			VAO["specularVBO"].setAttPointer<GLfloat>(2, 4, GL_FLOAT, 4, 0, 1);
 		}
+
+		if (mode == SurfaceMode::CPU || mode == SurfaceMode::TEXTURE) {
+			grid = GridMesh::acquire(x_cells, z_cells);
+		}
+		else if (usesPatches() && mode != SurfaceMode::GEOMETRY) {
+			grid = GridMesh::acquire(patchCells(), patchCells());
+		}
+		if (mode == SurfaceMode::CPU) {
+			heights.resize(noInstances * (x_cells + 1) * (z_cells + 1));
+			evaluateHeights();
+
+			heightsBuffer.generate();
+			heightsBuffer.bind();
+			heightsBuffer.setData<glm::vec4>((GLuint)heights.size(), heights.empty() ? nullptr : &heights[0], GL_DYNAMIC_DRAW);
+
+			glGenTextures(1, &heightsTexture);
+			glBindTexture(GL_TEXTURE_BUFFER, heightsTexture);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, heightsBuffer.val);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		else if (mode == SurfaceMode::CAPTURED) {
+			// two triangles per cell
+			capture.generate(x_cells * z_cells * 6 * noInstances);
+		}
+		else if (mode == SurfaceMode::TEXTURE) {
+			heightField.generate(x_cells, z_cells, noInstances);
+		}
+
+		// contour buffers are sized by the first extraction (in render)
+		contourShader = Shader(false, "contour.vert", "contour.frag");
+		contourShader.activate();
+		contourShader.set3Float("color", glm::vec3(0.05f));
+
+		contourVAO.generate();
+		contourVAO.bind();
+		contourVAO["VBO"] = BufferObject(GL_ARRAY_BUFFER);
+		contourVAO["VBO"].generate();
+		contourVAO["VBO"].bind();
+		contourVAO["VBO"].setData<glm::vec3>(0, nullptr, GL_DYNAMIC_DRAW);
+		contourVAO["VBO"].setAttPointer<GLfloat>(0, 3, GL_FLOAT, 3, 0);
+		contourVAO["EBO"] = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
+		contourVAO["EBO"].generate();
+		contourVAO["EBO"].bind();
+		contourVAO["EBO"].setData<GLuint>(0, nullptr, GL_DYNAMIC_DRAW);
+		ArrayObject::clear();
+
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(GRID_RESTART_INDEX);
 	}
 
 	bool update(double dt) {
+		bool ret = false;
+
 		if (transition.isRunning()) {
-			shader.activate();
+			double xOffset = transition.getCurrent();
 			transition.update(dt);
-			shader.setFloat("x_offset", (float)transition.getCurrent());
-			return true;
+			if (transition.getCurrent() != xOffset) {
+				uploads.setUniform<float>(functionShader(), xOffsetUniform, (float)transition.getCurrent());
+				ret = true;
+			}
 		}
 
-		return false;
+		if (expression->dependsOn('t')) {
+			time += dt;
+			uploads.setUniform<float>(functionShader(), timeUniform, (float)time);
+			ret = true;
+		}
+
+		// captured geometry, baked heights and patch ranges follow the uniforms
+		capture.dirty |= ret;
+		heightField.dirty |= ret;
+		rangesDirty |= ret;
+		contourHeightsDirty |= ret;
+
+		if (contourLinesDirty || (ret && !contourLevels.empty())) {
+			ret |= buildContours();
+		}
+
+		if (mode == SurfaceMode::CPU && (ret || heightsDirty) && !heights.empty()) {
+			evaluateHeights();
+			uploads.updateData<glm::vec4>(heightsBuffer, 0, (GLuint)heights.size(), &heights[0]);
+			ret = true;
+		}
+
+		if (usesPatches() && (ret || patchesDirty) && !patches.empty()) {
+			ret |= buildPatches();
+		}
+
+		if (mode == SurfaceMode::TEXTURE && heightField.dirty) {
+			// bake after the recorded uniforms are replayed, before the draws are queued
+			uploads.run([this]() {
+				heightField.bake(bakeShader, bounds);
+			});
+			ret = true;
+		}
+
+		return ret;
 	}
 
-	void render() {
-		shader.activate();
-		VAO.bind();
-		VAO.draw(GL_POINTS, 0, x_cells * z_cells, noInstances);
+	double nextUpdate() {
+		if ((mode == SurfaceMode::CPU && heightsDirty) || (mode == SurfaceMode::TEXTURE && heightField.dirty)
+			|| (usesPatches() && patchesDirty) || contourLinesDirty) {
+			return 0.0;
+		}
+		return expression->dependsOn('t') ? 0.0 : transition.nextChange();
+	}
+
+	void cameraChanged(glm::mat4 projView, glm::vec3 viewPos) {
+		if (!usesPatches()) {
+			return;
+		}
+
+		frustum = Frustum(projView);
+		quadtree.setCamera(projView, viewPos);
+		clipmap.setCamera(viewPos);
+		patchesDirty = true;
+	}
+
+	void render(DrawQueue& queue) {
+		if (mode == SurfaceMode::GEOMETRY) {
+			queue.draw(shader, VAO, GL_POINTS, 0, patchCells() * patchCells(), noPatches);
+		}
+		else if (usesPatches()) {
+			queue.draw(shader, VAO, GL_TRIANGLE_STRIP, grid->noIndices, GL_UNSIGNED_INT, 0, noPatches);
+		}
+		else if (mode == SurfaceMode::CPU) {
+			queue.setTexture(GL_TEXTURE_BUFFER, heightsTexture);
+			queue.draw(shader, VAO, GL_TRIANGLE_STRIP, grid->noIndices, GL_UNSIGNED_INT, 0, noInstances);
+			queue.setTexture(0, 0);
+		}
+		else if (mode == SurfaceMode::TEXTURE) {
+			queue.setTexture(GL_TEXTURE_2D_ARRAY, heightField.texture);
+			queue.draw(shader, VAO, GL_TRIANGLE_STRIP, grid->noIndices, GL_UNSIGNED_INT, 0, noInstances);
+			queue.setTexture(0, 0);
+		}
+		else if (mode == SurfaceMode::CAPTURED) {
+			if (capture.dirty) {
+				// surface.geom writes two triangles for every cell
+				capture.capture(shader, VAO, GL_POINTS, 0, x_cells * z_cells, noInstances, x_cells * z_cells * 6 * noInstances);
+			}
+			capture.draw(queue);
+		}
+
+		if (contourReallocate) {
+			// grow with headroom so moving the levels does not re-specify the buffers every time
+			unsigned int noVertices = (unsigned int)contours.vertices.size();
+			contourVertexCapacity = noVertices + noVertices / 2;
+			contourIndexCapacity = noContourIndices + noContourIndices / 2;
+			contourVAO.bind();
+			contourVAO["VBO"].bind();
+			contourVAO["VBO"].setData<glm::vec3>(contourVertexCapacity, nullptr, GL_DYNAMIC_DRAW);
+			contourVAO["VBO"].updateData<glm::vec3>(0, noVertices, &contours.vertices[0]);
+			contourVAO["EBO"].bind();
+			contourVAO["EBO"].setData<GLuint>(contourIndexCapacity, nullptr, GL_DYNAMIC_DRAW);
+			contourVAO["EBO"].updateData<GLuint>(0, noContourIndices, &contourIndices[0]);
+			ArrayObject::clear();
+			contourReallocate = false;
+		}
+
+		if (noContourIndices) {
+			queue.draw(contourShader, contourVAO, GL_LINE_STRIP, noContourIndices, GL_UNSIGNED_INT, 0);
+		}
 	}
 
 	void cleanup() {
-		shader.cleanup();
+		// shader is a copy of one of the variants
+		variants.cleanup();
+		loaded = false;
 		VAO.cleanup();
+		GridMesh::release(grid);
+		grid = nullptr;
+		if (mode == SurfaceMode::CAPTURED) {
+			capture.cleanup();
+		}
+		else if (mode == SurfaceMode::TEXTURE) {
+			// bakeShader is a copy of one of the variants
+			shader.cleanup();
+			heightField.cleanup();
+		}
+		else if (mode == SurfaceMode::CPU) {
+			shader.cleanup();
+			glDeleteTextures(1, &heightsTexture);
+			heightsTexture = 0;
+			heightsBuffer.cleanup();
+			heights.clear();
+		}
+		contourShader.cleanup();
+		contourVAO.cleanup();
+		contours.clear();
+		contourHeights.clear();
+		contourIndices.clear();
+		noContourIndices = contourVertexCapacity = contourIndexCapacity = 0;
+		contourHeightsDirty = true;
+		contourLinesDirty = !contourLevels.empty();
+		contourReallocate = false;
+		patches.clear();
+		noPatches = 0;
+		chunks.clear();
+		ranges.clear();
 		bounds.clear();
 		diffuse.clear();
 		specular.clear();
@@ -110,15 +741,42 @@ public:
 		if (key == GLFW_KEY_C) {
 			if (Keyboard::keyWentDown(GLFW_KEY_C)) {
 				calculus = !calculus;
-				shader.setBool("calculus", calculus);
+				functionShader().activate();
+				calculusUniform.set(calculus);
+				capture.dirty = true;
+				heightField.dirty = true;
+				heightsDirty = true;
 				return true;
 			}
 		}
 
+		if (key == GLFW_KEY_F && Keyboard::keyWentDown(GLFW_KEY_F)) {
+			// next preset
+			preset = (preset + 1) % (sizeof(surfacePresets) / sizeof(surfacePresets[0]));
+			setExpression(surfacePresets[preset]);
+			return true;
+		}
+
 		if (key == GLFW_KEY_T && Keyboard::keyWentDown(GLFW_KEY_T)) {
 			transition.toggleRunning();
 		}
 
+		if (key == GLFW_KEY_L && Keyboard::keyWentDown(GLFW_KEY_L)) {
+			// toggle contours
+			setContours(contourLevels.empty() ? defaultContourLevels() : std::vector<float>());
+			return true;
+		}
+
+		if ((key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD) && action != GLFW_RELEASE && contourLevels.size() > 1) {
+			// move the levels by a quarter of their spacing, only the extraction is redone
+			float shift = 0.25f * fabsf(contourLevels[1] - contourLevels[0]) * (key == GLFW_KEY_COMMA ? -1.0f : 1.0f);
+			for (float& level : contourLevels) {
+				level += shift;
+			}
+			contourLinesDirty = true;
+			return true;
+		}
+
 		return false;
 	}
 };
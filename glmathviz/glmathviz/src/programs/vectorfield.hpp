@@ -0,0 +1,282 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <math.h>
+#include <string>
+#include <iostream>
+
+#include "program.h"
+#include "../rendering/shader.h"
+#include "../rendering/material.h"
+#include "../rendering/vertexmemory.hpp"
+#include "../rendering/shadervariants.hpp"
+#include "../rendering/arrowmesh.hpp"
+#include "../math/expression.h"
+#include "../io/framescheduler.h"
+#include "../io/keyboard.h"
+
+#ifndef VECTORFIELD_HPP
+#define VECTORFIELD_HPP
+
+// field F(x, y, z, t) = (x, y, z) components
+typedef struct {
+	const char* x;
+	const char* y;
+	const char* z;
+} VectorFieldPreset;
+
+// presets cycled through with B
+const VectorFieldPreset vectorFieldPresets[] = {
+	{ "-z", "0.25 * y", "x" }, // swirl around the y axis
+	{ "x", "y", "z" }, // source
+	{ "y*z", "x*z", "x*y" }, // gradient of x*y*z
+	{ "sin(y + t)", "sin(z + t)", "sin(x + t)" } // travelling Arnold-Beltrami-Childress flow
+};
+
+// level of detail of the arrows (see ArrowMesh)
+#define VECTORFIELD_ARROW_LOD 1
+// lattice points per axis sampled on the CPU for the automatic magnitude scale
+#define VECTORFIELD_SCALE_SAMPLES 8
+
+/*
+	arrows of a vector field F(x, y, z, t) on a regular lattice
+	- one instance of the unit arrow mesh per lattice point, the point comes from gl_InstanceID
+	- direction, length and colour by magnitude are computed in vectorfield.vert, no per-arrow data on the CPU
+	- full length is the lattice spacing, reached at the magnitude scale (largest sampled magnitude by default)
+*/
+
+class VectorField : public Program {
+	ArrayObject VAO;
+	ArrowMesh* mesh;
+
+	// lattice from min to max with samples points per axis
+	glm::vec3 min;
+	glm::vec3 max;
+	glm::ivec3 samples;
+
+	glm::vec4 specular;
+
+	// magnitude drawn at full length, 0 for automatic
+	float magnitudeScale;
+	float sampledMagnitude;
+
+	// components of F(x, y, z, t)
+	ExprPtr components[3];
+	unsigned int preset;
+	double time;
+
+	// compiled programs by hash of the generated source
+	ShaderVariants variants;
+	bool loaded;
+
+	UniformHandle<float> timeUniform;
+	UniformHandle<float> magnitudeUniform;
+
+	bool dependsOnTime() {
+		return components[0]->dependsOn('t') || components[1]->dependsOn('t') || components[2]->dependsOn('t');
+	}
+
+	unsigned int noArrows() {
+		return samples.x * samples.y * samples.z;
+	}
+
+	glm::vec3 spacing() {
+		return (max - min) / glm::vec3(glm::max(samples - glm::ivec3(1), glm::ivec3(1)));
+	}
+
+	// length of a full arrow, a little less than the closest lattice points
+	float maxLength() {
+		glm::vec3 d = spacing();
+		return 0.9f * glm::min(d.x, glm::min(d.y, d.z));
+	}
+
+	float currentMagnitudeScale() {
+		return magnitudeScale > 0.0f ? magnitudeScale : sampledMagnitude;
+	}
+
+	// largest finite magnitude on a coarse lattice over the same box
+	float sampleMagnitude() {
+		glm::ivec3 n = glm::min(samples, glm::ivec3(VECTORFIELD_SCALE_SAMPLES));
+		glm::dvec3 step = glm::dvec3(max - min) / glm::dvec3(glm::max(n - glm::ivec3(1), glm::ivec3(1)));
+		double ret = 0.0;
+		for (int i = 0; i < n.x; i++) {
+			for (int j = 0; j < n.y; j++) {
+				for (int k = 0; k < n.z; k++) {
+					glm::dvec3 p = glm::dvec3(min) + glm::dvec3(i, j, k) * step;
+					glm::dvec3 F(
+						components[0]->evaluate(p.x, p.y, p.z, time),
+						components[1]->evaluate(p.x, p.y, p.z, time),
+						components[2]->evaluate(p.x, p.y, p.z, time));
+					double mag = glm::length(F);
+					if (isfinite(mag) && mag > ret) {
+						ret = mag;
+					}
+				}
+			}
+		}
+		return ret > 0.0 ? (float)ret : 1.0f;
+	}
+
+	// GLSL defining field
+	std::string generateSource() {
+		std::string ret = "#version 330 core\n"
+			"uniform float time;\n"
+			+ Expression::glslPrelude() +
+			"vec3 field(vec3 p) {\n"
+			"	float x = p.x;\n"
+			"	float y = p.y;\n"
+			"	float z = p.z;\n"
+			"	return vec3(";
+		for (int i = 0; i < 3; i++) {
+			ret += components[i]->toGLSL();
+			ret += i < 2 ? ", " : ");\n";
+		}
+		return ret + "}\n";
+	}
+
+	// switch to the variant for the current components, compiling it on first use
+	void useVariant() {
+		std::string src = generateSource();
+		unsigned long long key = Expression::hash(src);
+
+		Shader* variant = variants.find(key, src);
+		if (!variant) {
+			Shader compiled;
+			compiled.generate(false, "vectorfield.vert", "dirlight.frag", nullptr, GL_VERTEX_SHADER, src);
+			compiled.activate();
+			float length = maxLength();
+			compiled.set3Float("samples", glm::vec3(samples));
+			compiled.set3Float("minCorner", min);
+			compiled.set3Float("spacing", spacing());
+			compiled.setFloat("maxLength", length);
+			compiled.set3Float("shape", glm::vec3(0.05f, 0.12f, 0.3f) * length);
+			variant = variants.add(key, src, compiled);
+		}
+
+		// uniforms are per program, restore the current state
+		shader = *variant;
+		shader.activate();
+		shader.set4Float("specular", specular);
+		timeUniform = shader.getUniform<float>("time");
+		magnitudeUniform = shader.getUniform<float>("magnitudeScale");
+		timeUniform.set((float)time);
+		magnitudeUniform.set(currentMagnitudeScale());
+	}
+
+public:
+	VectorField(glm::vec3 min = glm::vec3(-2.0f), glm::vec3 max = glm::vec3(2.0f),
+		glm::ivec3 samples = glm::ivec3(9), unsigned int preset = 0)
+		: mesh(nullptr), min(min), max(max), samples(glm::max(samples, glm::ivec3(1))),
+		specular(0.5f, 0.5f, 0.5f, 32.0f), magnitudeScale(0.0f), sampledMagnitude(1.0f),
+		preset(0), time(0.0), loaded(false) {
+		if (preset >= sizeof(vectorFieldPresets) / sizeof(vectorFieldPresets[0]) || !setPreset(preset)) {
+			setPreset(0);
+		}
+	}
+
+	// parse and use new components F(x, y, z, t), keeps the current ones on a parse error
+	bool setExpression(const std::string& x, const std::string& y, const std::string& z) {
+		const std::string* src[3] = { &x, &y, &z };
+		ExprPtr parsed[3];
+		for (int i = 0; i < 3; i++) {
+			std::string error;
+			parsed[i] = Expression::parse(*src[i], error, "xyzt");
+			if (!parsed[i]) {
+				std::cout << "Could not parse vector field component \"" << *src[i] << "\": " << error << std::endl;
+				return false;
+			}
+		}
+
+		for (int i = 0; i < 3; i++) {
+			components[i] = parsed[i];
+		}
+		sampledMagnitude = sampleMagnitude();
+		if (loaded) {
+			useVariant();
+		}
+		return true;
+	}
+
+	bool setPreset(unsigned int newPreset) {
+		const VectorFieldPreset& next = vectorFieldPresets[newPreset];
+		if (!setExpression(next.x, next.y, next.z)) {
+			return false;
+		}
+
+		preset = newPreset;
+		return true;
+	}
+
+	// magnitude drawn at full length (0 for the largest sampled magnitude)
+	void setMagnitudeScale(float scale) {
+		magnitudeScale = scale;
+		if (loaded) {
+			shader.activate();
+			magnitudeUniform.set(currentMagnitudeScale());
+		}
+	}
+
+	void setMaterial(Material material) {
+		specular = glm::vec4(material.specular, material.shininess);
+		if (loaded) {
+			shader.activate();
+			shader.set4Float("specular", specular);
+		}
+	}
+
+	void load() {
+		loaded = true;
+		useVariant();
+
+		// no instance attributes, the lattice point comes from gl_InstanceID
+		VAO.generate();
+		VAO.bind();
+		mesh = ArrowMesh::acquire(0);
+		ArrayObject::clear();
+	}
+
+	bool update(double dt) {
+		if (dependsOnTime()) {
+			time += dt;
+			uploads.setUniform<float>(shader, timeUniform, (float)time);
+			if (magnitudeScale <= 0.0f) {
+				sampledMagnitude = sampleMagnitude();
+				uploads.setUniform<float>(shader, magnitudeUniform, sampledMagnitude);
+			}
+			return true;
+		}
+
+		return false;
+	}
+
+	double nextUpdate() {
+		return dependsOnTime() ? 0.0 : FrameScheduler::never;
+	}
+
+	void render(DrawQueue& queue) {
+		queue.draw(shader, VAO, GL_TRIANGLES, mesh->noIndices[VECTORFIELD_ARROW_LOD], GL_UNSIGNED_INT,
+			mesh->indexOffset(VECTORFIELD_ARROW_LOD), noArrows());
+	}
+
+	void cleanup() {
+		// shader is a copy of one of the variants
+		variants.cleanup();
+		loaded = false;
+		VAO.cleanup();
+		ArrowMesh::release(mesh);
+		mesh = nullptr;
+	}
+
+	bool keyChanged(GLFWwindow* window, int key, int scancode, int action, int mods) {
+		if (key == GLFW_KEY_B && Keyboard::keyWentDown(GLFW_KEY_B)) {
+			// next preset
+			setPreset((preset + 1) % (sizeof(vectorFieldPresets) / sizeof(vectorFieldPresets[0])));
+			return true;
+		}
+
+		return false;
+	}
+};
+
+#endif // VECTORFIELD_HPP
@@ -0,0 +1,131 @@
+#ifndef ARROWMESH_HPP
+#define ARROWMESH_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <math.h>
+#include <vector>
+
+#include "vertexmemory.hpp"
+
+// parts of the arrow a unit vertex belongs to
+#define ARROW_ARM_BASE 0.0f
+#define ARROW_ARM_TOP 1.0f
+#define ARROW_HEAD_BASE 2.0f
+#define ARROW_TIP 3.0f
+
+#define ARROW_NO_LODS 4
+
+// edges around the arrow per level of detail, finest first
+const int arrowLodEdges[ARROW_NO_LODS] = { 15, 8, 5, 3 };
+// smallest projected size (bounding sphere diameter in pixels) drawn at each level of detail
+const float arrowLodPixels[ARROW_NO_LODS] = { 96.0f, 32.0f, 8.0f, 1.0f };
+
+/*
+    unit arrow (open cylinder and cone around the y axis) at every level of detail, shared by all users
+    - vertex = (cos, sin, part) of its angle around the axis, the vertex shader scales it by the arrow's dimensions
+    - the tip is repeated per edge so each cone face gets the normal of its middle
+    - indexed triangles, the levels are consecutive ranges of one vertex and one index buffer
+*/
+
+class ArrowMesh {
+public:
+    BufferObject VBO;
+    BufferObject EBO;
+
+    // index range of each level of detail
+    GLuint firstIndex[ARROW_NO_LODS];
+    GLuint noIndices[ARROW_NO_LODS];
+
+    // number of users of the mesh
+    unsigned int users;
+
+    ArrowMesh()
+        : users(0) {}
+
+    // get the mesh (generated on first use)
+    // - call with the user's VAO bound, the unit vertices are attached at attribute
+    static ArrowMesh* acquire(GLuint attribute) {
+        ArrowMesh& mesh = instance();
+        if (!mesh.users) {
+            mesh.generate();
+        }
+        mesh.attach(attribute);
+        mesh.users++;
+
+        return &mesh;
+    }
+
+    // release the mesh, deleted with its last user
+    static void release(ArrowMesh* mesh) {
+        if (mesh && !--mesh->users) {
+            mesh->VBO.cleanup();
+            mesh->EBO.cleanup();
+        }
+    }
+
+    // attach the unit vertices and indices to another bound VAO of the same user
+    void attach(GLuint attribute) {
+        VBO.bind();
+        VBO.setAttPointer<GLfloat>(attribute, 3, GL_FLOAT, 3, 0);
+        EBO.bind();
+    }
+
+    // offset of a level's first index (for glDrawElements)
+    GLint indexOffset(int lod) {
+        return (GLint)(firstIndex[lod] * sizeof(GLuint));
+    }
+
+private:
+    static ArrowMesh& instance() {
+        static ArrowMesh ret;
+        return ret;
+    }
+
+    void generate() {
+        std::vector<glm::vec3> vertices;
+        std::vector<GLuint> indices;
+
+        for (int lod = 0; lod < ARROW_NO_LODS; lod++) {
+            // rings of noEdges vertices: arm base, arm top, head base, tip
+            int noEdges = arrowLodEdges[lod];
+            GLuint base = (GLuint)vertices.size();
+            float increment = glm::two_pi<float>() / (float)noEdges;
+            vertices.resize(base + 4 * noEdges);
+            for (int k = 0; k < noEdges; k++) {
+                glm::vec2 dir(cos(k * increment), sin(k * increment));
+                glm::vec2 mid(cos((k + 0.5f) * increment), sin((k + 0.5f) * increment));
+                vertices[base + k] = glm::vec3(dir, ARROW_ARM_BASE);
+                vertices[base + noEdges + k] = glm::vec3(dir, ARROW_ARM_TOP);
+                vertices[base + 2 * noEdges + k] = glm::vec3(dir, ARROW_HEAD_BASE);
+                vertices[base + 3 * noEdges + k] = glm::vec3(mid, ARROW_TIP);
+            }
+
+            firstIndex[lod] = (GLuint)indices.size();
+            for (int k = 0; k < noEdges; k++) {
+                GLuint cur = base + k;
+                GLuint next = base + (k + 1) % noEdges;
+                // arm side
+                indices.insert(indices.end(), { cur, next, noEdges + cur });
+                indices.insert(indices.end(), { noEdges + cur, next, noEdges + next });
+                // head side
+                indices.insert(indices.end(), { 2 * noEdges + cur, 2 * noEdges + next, 3 * noEdges + cur });
+            }
+            noIndices[lod] = (GLuint)indices.size() - firstIndex[lod];
+        }
+
+        VBO = BufferObject(GL_ARRAY_BUFFER);
+        VBO.generate();
+        VBO.bind();
+        VBO.setData<glm::vec3>((GLuint)vertices.size(), &vertices[0], GL_STATIC_DRAW);
+
+        EBO = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
+        EBO.generate();
+        EBO.bind();
+        EBO.setData<GLuint>((GLuint)indices.size(), &indices[0], GL_STATIC_DRAW);
+    }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef DRAWQUEUE_HPP
+#define DRAWQUEUE_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "shader.h"
+#include "vertexmemory.hpp"
+#include "../profiling/gputimer.h"
+#include "../profiling/tracer.h"
+
+/*
+    lightweight description of one draw call
+*/
+
+typedef struct {
+    Shader* shader;
+    ArrayObject* VAO;
+
+    // draw parameters
+    bool indexed;
+    GLenum mode;
+    GLuint first; // first vertex (arrays)
+    GLuint count;
+    GLenum indexType; // (elements)
+    GLint indices; // offset into the element buffer (elements)
+    GLuint instancecount;
+
+    // texture bound to unit 0 (0 = none needed)
+    GLenum textureTarget;
+    GLuint texture;
+
+    // GPU timer of the submitting program (may be null)
+    GpuTimer* timer;
+    // submission order, keeps sorting stable
+    unsigned int order;
+} DrawPacket;
+
+/*
+    per-frame queue of draw packets
+    - programs push packets while rendering
+    - flush sorts them by shader and VAO and binds state only when it changes
+*/
+
+class DrawQueue {
+public:
+    std::vector<DrawPacket> packets;
+
+    /*
+        submission
+    */
+
+    // tag following packets with a GPU timer (set by ProgramTimer)
+    void setTimer(GpuTimer* timer) {
+        currentTimer = timer;
+    }
+
+    // bind a texture to unit 0 for following packets (0 to stop)
+    void setTexture(GLenum target, GLuint texture) {
+        currentTextureTarget = target;
+        currentTexture = texture;
+    }
+
+    // queue draw arrays
+    void draw(Shader& shader, ArrayObject& VAO, GLenum mode, GLuint first, GLuint count, GLuint instancecount = 1) {
+        if (!count || !instancecount) {
+            return;
+        }
+
+        packets.push_back({ &shader, &VAO, false, mode, first, count, 0, 0, instancecount,
+            currentTextureTarget, currentTexture, currentTimer, (unsigned int)packets.size() });
+    }
+
+    // queue draw elements
+    void draw(Shader& shader, ArrayObject& VAO, GLenum mode, GLuint count, GLenum type, GLint indices, GLuint instancecount = 1) {
+        if (!count || !instancecount) {
+            return;
+        }
+
+        packets.push_back({ &shader, &VAO, true, mode, 0, count, type, indices, instancecount,
+            currentTextureTarget, currentTexture, currentTimer, (unsigned int)packets.size() });
+    }
+
+    /*
+        processing
+    */
+
+    // sort by shader, then VAO, then submission order
+    void sort() {
+        std::sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b) {
+            if (a.shader->id != b.shader->id) {
+                return a.shader->id < b.shader->id;
+            }
+            if (a.VAO->val != b.VAO->val) {
+                return a.VAO->val < b.VAO->val;
+            }
+            return a.order < b.order;
+        });
+    }
+
+    // sort, submit and clear
+    // - GPU timers bracket each contiguous run of packets from the same program, runs add up to one sample
+    void flush() {
+        TRACE_SCOPE("DrawQueue::flush", "render");
+
+        sort();
+
+        GLuint boundShader = 0;
+        GLuint boundVAO = 0;
+        GLuint boundTexture = 0;
+        GpuTimer* runningTimer = nullptr;
+
+        for (DrawPacket& packet : packets) {
+            if (packet.timer != runningTimer) {
+                if (runningTimer) {
+                    runningTimer->end();
+                }
+                runningTimer = packet.timer;
+                if (runningTimer) {
+                    runningTimer->begin();
+                }
+            }
+
+            if (packet.shader->id != boundShader) {
+                packet.shader->activate();
+                boundShader = packet.shader->id;
+            }
+            if (packet.VAO->val != boundVAO) {
+                packet.VAO->bind();
+                boundVAO = packet.VAO->val;
+            }
+            if (packet.texture && packet.texture != boundTexture) {
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(packet.textureTarget, packet.texture);
+                boundTexture = packet.texture;
+            }
+
+            if (packet.indexed) {
+                packet.VAO->draw(packet.mode, packet.count, packet.indexType, packet.indices, packet.instancecount);
+            }
+            else {
+                packet.VAO->draw(packet.mode, packet.first, packet.count, packet.instancecount);
+            }
+        }
+
+        if (runningTimer) {
+            runningTimer->end();
+        }
+
+        packets.clear();
+    }
+
+private:
+    GLenum currentTextureTarget = 0;
+    GLuint currentTexture = 0;
+    GpuTimer* currentTimer = nullptr;
+};
+
+#endif
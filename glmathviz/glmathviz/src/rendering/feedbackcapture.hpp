@@ -0,0 +1,104 @@
+#ifndef FEEDBACKCAPTURE_HPP
+#define FEEDBACKCAPTURE_HPP
+
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "vertexmemory.hpp"
+#include "drawqueue.hpp"
+#include "../profiling/tracer.h"
+
+// floats per captured vertex (fragPos, normal, diffMap, specMap, shininess)
+#define CAPTURE_VERTEX_FLOATS 13
+
+/*
+    geometry shader output cached with transform feedback
+    - capture runs the generating program once with rasterization off and stores its triangles
+    - later frames draw the stored triangles with captured.vert, so they only pay for rasterization
+    - the caller gives the number of vertices the generating draw writes, reading it back from a
+      query would wait for the GPU on every capture
+*/
+
+class FeedbackCapture {
+public:
+    // number of vertices stored by the last capture
+    GLuint noVertices;
+
+    // set when the captured geometry is out of date
+    bool dirty;
+
+    FeedbackCapture()
+        : noVertices(0), dirty(true), maxVertices(0) {}
+
+    // request capture of the shared varyings when the generating shader is linked
+    static void prepareShader(Shader& shader) {
+        static const char* varyings[] = { "fragPos", "normal", "diffMap", "specMap", "shininess" };
+        shader.feedbackVaryings.assign(varyings, varyings + 5);
+    }
+
+    // create buffers and the draw shader
+    void generate(GLuint maxVertices) {
+        this->maxVertices = maxVertices;
+
+        drawShader = Shader(false, "captured.vert", "dirlight.frag");
+
+        VAO.generate();
+        VAO.bind();
+
+        VAO["VBO"] = BufferObject(GL_ARRAY_BUFFER);
+        VAO["VBO"].generate();
+        VAO["VBO"].bind();
+        VAO["VBO"].setData<GLfloat>(maxVertices * CAPTURE_VERTEX_FLOATS, NULL, GL_DYNAMIC_COPY);
+        VAO["VBO"].setAttPointer<GLfloat>(0, 3, GL_FLOAT, CAPTURE_VERTEX_FLOATS, 0); // pos
+        VAO["VBO"].setAttPointer<GLfloat>(1, 3, GL_FLOAT, CAPTURE_VERTEX_FLOATS, 3); // normal
+        VAO["VBO"].setAttPointer<GLfloat>(2, 3, GL_FLOAT, CAPTURE_VERTEX_FLOATS, 6); // diffuse
+        VAO["VBO"].setAttPointer<GLfloat>(3, 3, GL_FLOAT, CAPTURE_VERTEX_FLOATS, 9); // specular
+        VAO["VBO"].setAttPointer<GLfloat>(4, 1, GL_FLOAT, CAPTURE_VERTEX_FLOATS, 12); // shininess
+
+        ArrayObject::clear();
+        dirty = true;
+    }
+
+    // run the generating draw into the buffer (GL thread, outside of a queue flush)
+    // - noVertices is what the draw writes (3 per output triangle, strips are split into triangles)
+    void capture(Shader& shader, ArrayObject& sourceVAO, GLenum mode, GLuint first, GLuint count, GLuint instancecount,
+        GLuint noVertices) {
+        TRACE_SCOPE("FeedbackCapture::capture", "render");
+
+        shader.activate();
+        sourceVAO.bind();
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, VAO["VBO"].val);
+        glBeginTransformFeedback(GL_TRIANGLES);
+        sourceVAO.draw(mode, first, count, instancecount);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        // writes past the buffer are dropped
+        this->noVertices = noVertices < maxVertices ? noVertices : maxVertices;
+
+        ArrayObject::clear();
+        dirty = false;
+    }
+
+    // queue the captured triangles
+    void draw(DrawQueue& queue) {
+        queue.draw(drawShader, VAO, GL_TRIANGLES, 0, noVertices);
+    }
+
+    void cleanup() {
+        drawShader.cleanup();
+        VAO.cleanup();
+        noVertices = 0;
+    }
+
+private:
+    GLuint maxVertices;
+
+    Shader drawShader;
+    ArrayObject VAO;
+};
+
+#endif
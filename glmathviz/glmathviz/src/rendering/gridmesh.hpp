@@ -0,0 +1,91 @@
+#ifndef GRIDMESH_HPP
+#define GRIDMESH_HPP
+
+#include <glad/glad.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "vertexmemory.hpp"
+
+// index separating the triangle strips
+#define GRID_RESTART_INDEX 0xFFFFFFFF
+
+/*
+    index buffer of a regular grid, shared by every user with the same resolution
+    - vertex index = x * (z_cells + 1) + z, positions are computed in the vertex shader
+    - one triangle strip per x row, separated by primitive restart
+*/
+
+class GridMesh {
+public:
+    int x_cells;
+    int z_cells;
+
+    BufferObject EBO;
+    GLuint noIndices;
+
+    // number of users of the mesh
+    unsigned int users;
+
+    GridMesh()
+        : x_cells(0), z_cells(0), noIndices(0), users(0) {}
+
+    // get the mesh for a resolution (generated on first use, call with the user's VAO bound)
+    static GridMesh* acquire(int x_cells, int z_cells) {
+        GridMesh& mesh = meshes()[std::make_pair(x_cells, z_cells)];
+        if (!mesh.users) {
+            mesh.x_cells = x_cells;
+            mesh.z_cells = z_cells;
+            mesh.generate();
+        }
+        else {
+            // attach to the bound VAO
+            mesh.EBO.bind();
+        }
+        mesh.users++;
+
+        return &mesh;
+    }
+
+    // release a mesh, deleted with its last user
+    static void release(GridMesh* mesh) {
+        if (mesh && !--mesh->users) {
+            mesh->EBO.cleanup();
+            meshes().erase(std::make_pair(mesh->x_cells, mesh->z_cells));
+        }
+    }
+
+private:
+    // meshes by resolution
+    static std::map<std::pair<int, int>, GridMesh>& meshes() {
+        static std::map<std::pair<int, int>, GridMesh> ret;
+        return ret;
+    }
+
+    void generate() {
+        std::vector<GLuint> indices;
+        indices.reserve(x_cells * (2 * (z_cells + 1) + 1));
+
+        GLuint rowLength = z_cells + 1;
+        for (int i = 0; i < x_cells; i++) {
+            for (int j = 0; j <= z_cells; j++) {
+                indices.push_back(i * rowLength + j);
+                indices.push_back((i + 1) * rowLength + j);
+            }
+            indices.push_back(GRID_RESTART_INDEX);
+        }
+        noIndices = (GLuint)indices.size();
+
+        EBO = BufferObject(GL_ELEMENT_ARRAY_BUFFER);
+        EBO.generate();
+        EBO.bind();
+        EBO.setData<GLuint>(noIndices, &indices[0], GL_STATIC_DRAW);
+
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(GRID_RESTART_INDEX);
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef HEIGHTFIELD_HPP
+#define HEIGHTFIELD_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "shader.h"
+#include "vertexmemory.hpp"
+#include "../profiling/tracer.h"
+
+/*
+    surface heights and normals cached in a float texture array, one layer per instance
+    - bake renders the function into every layer with a fullscreen pass (surface_bake.vert)
+    - texel (x, z) of a layer holds (normal, y) of grid vertex (x, z)
+    - redraws only fetch texels, the function runs again only when the cache is dirty
+*/
+
+class HeightField {
+public:
+    // texture array of the cached grids
+    GLuint texture;
+
+    // set when the cached heights are out of date
+    bool dirty;
+
+    HeightField()
+        : texture(0), dirty(true), width(0), height(0), layers(0), fbo(0) {}
+
+    // create the texture and framebuffer for layers grids of x_cells x z_cells cells
+    void generate(int x_cells, int z_cells, unsigned int layers) {
+        width = x_cells + 1;
+        height = z_cells + 1;
+        this->layers = layers;
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32F, width, height, layers, 0, GL_RGBA, GL_FLOAT, NULL);
+        // only read with texelFetch, but must be complete without mipmaps
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &fbo);
+        VAO.generate();
+        dirty = true;
+    }
+
+    // evaluate the surface into every layer (GL thread, before the frame's draws are queued)
+    // - bakeShader takes the instance bounds in the "bounds" uniform
+    void bake(Shader& bakeShader, const std::vector<glm::vec4>& bounds) {
+        TRACE_SCOPE("HeightField::bake", "render");
+
+        // keep the caller's target and depth test
+        GLint prevFbo = 0;
+        GLint prevViewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFbo);
+        glGetIntegerv(GL_VIEWPORT, prevViewport);
+        GLboolean prevDepthTest = glIsEnabled(GL_DEPTH_TEST);
+
+        bakeShader.activate();
+        UniformHandle<glm::vec4> boundsUniform = bakeShader.getUniform<glm::vec4>("bounds");
+        VAO.bind();
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+        glDisable(GL_DEPTH_TEST);
+
+        for (unsigned int i = 0; i < layers && i < bounds.size(); i++) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, i);
+            boundsUniform.set(bounds[i]);
+            // fullscreen triangle from gl_VertexID
+            VAO.draw(GL_TRIANGLES, 0, 3);
+        }
+
+        if (prevDepthTest) {
+            glEnable(GL_DEPTH_TEST);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+        glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+        ArrayObject::clear();
+        dirty = false;
+    }
+
+    void cleanup() {
+        glDeleteTextures(1, &texture);
+        glDeleteFramebuffers(1, &fbo);
+        VAO.cleanup();
+        texture = 0;
+        fbo = 0;
+    }
+
+private:
+    GLsizei width;
+    GLsizei height;
+    unsigned int layers;
+
+    GLuint fbo;
+    // empty, the pass has no attributes
+    ArrayObject VAO;
+};
+
+#endif
@@ -1,6 +1,11 @@
-#include "Shader.h"
+#include "shader.h"
+
+#include "../profiling/glstats.h"
+#include "../profiling/tracer.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <fstream>
 
 /*
@@ -29,14 +34,12 @@ void compileAndAttach(GLuint id, bool includeDefaultHeader, const char* path, GL
     glDeleteShader(shader);
 }
 
-// generate using vertex and frag shaders
-void Shader::generate(bool includeDefaultHeader, const char* vertexShaderPath, const char* fragShaderPath, const char* geoShaderPath) {
-    id = glCreateProgram();
-
-    // compile and attach shaders
-    compileAndAttach(id, includeDefaultHeader, vertexShaderPath, GL_VERTEX_SHADER);
-    compileAndAttach(id, includeDefaultHeader, fragShaderPath, GL_FRAGMENT_SHADER);
-    compileAndAttach(id, includeDefaultHeader, geoShaderPath, GL_GEOMETRY_SHADER);
+// link attached shaders and report errors
+void linkProgram(Shader& shader) {
+    GLuint id = shader.id;
+    if (!shader.feedbackVaryings.empty()) {
+        glTransformFeedbackVaryings(id, (GLsizei)shader.feedbackVaryings.size(), &shader.feedbackVaryings[0], GL_INTERLEAVED_ATTRIBS);
+    }
     glLinkProgram(id);
 
     // linking errors
@@ -47,16 +50,102 @@ void Shader::generate(bool includeDefaultHeader, const char* vertexShaderPath, c
         glGetProgramInfoLog(id, 512, NULL, infoLog);
         std::cout << "Linking error:" << std::endl << infoLog << std::endl;
     }
+
+    shader.reflectUniforms();
+    for (void(*callback)(Shader& shader) : Shader::linkCallbacks) {
+        callback(shader);
+    }
+}
+
+// generate using vertex and frag shaders
+void Shader::generate(bool includeDefaultHeader, const char* vertexShaderPath, const char* fragShaderPath, const char* geoShaderPath) {
+    id = glCreateProgram();
+
+    // compile and attach shaders
+    compileAndAttach(id, includeDefaultHeader, vertexShaderPath, GL_VERTEX_SHADER);
+    compileAndAttach(id, includeDefaultHeader, fragShaderPath, GL_FRAGMENT_SHADER);
+    compileAndAttach(id, includeDefaultHeader, geoShaderPath, GL_GEOMETRY_SHADER);
+    linkProgram(*this);
+}
+
+// generate with an additional shader object compiled from source
+void Shader::generate(bool includeDefaultHeader, const char* vertexShaderPath, const char* fragShaderPath, const char* geoShaderPath,
+    GLenum generatedType, const std::string& generatedSrc) {
+    id = glCreateProgram();
+
+    // compile and attach shaders
+    compileAndAttach(id, includeDefaultHeader, vertexShaderPath, GL_VERTEX_SHADER);
+    compileAndAttach(id, includeDefaultHeader, fragShaderPath, GL_FRAGMENT_SHADER);
+    compileAndAttach(id, includeDefaultHeader, geoShaderPath, GL_GEOMETRY_SHADER);
+
+    GLuint generated = compileShaderSrc(generatedSrc.c_str(), "<generated>", generatedType);
+    glAttachShader(id, generated);
+    glDeleteShader(generated);
+
+    linkProgram(*this);
 }
 
 // activate shader
 void Shader::activate() {
     glUseProgram(id);
+    GLStats::countProgram(id);
 }
 
 // cleanup
 void Shader::cleanup() {
     glDeleteProgram(id);
+    GLStats::resetProgram();
+}
+
+// read all active uniform locations
+void Shader::reflectUniforms() {
+    uniformLocations.clear();
+
+    GLint noUniforms = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &noUniforms);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    if (!noUniforms || !maxLength) {
+        return;
+    }
+
+    std::string name(maxLength, '\0');
+    for (GLint i = 0; i < noUniforms; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, (GLuint)i, maxLength, &length, &size, &type, &name[0]);
+
+        std::string uniformName = name.substr(0, length);
+        GLint location = glGetUniformLocation(id, uniformName.c_str());
+        if (location < 0) {
+            // member of a uniform block
+            continue;
+        }
+
+        uniformLocations[uniformName] = location;
+
+        // arrays are reported once as "name[0]", also allow "name" and add the other active elements
+        size_t bracket = uniformName.rfind("[0]");
+        if (bracket != std::string::npos && bracket + 3 == uniformName.size()) {
+            std::string base = uniformName.substr(0, bracket);
+            uniformLocations[base] = location;
+            for (GLint k = 1; k < size; k++) {
+                std::string elementName = base + "[" + std::to_string(k) + "]";
+                uniformLocations[elementName] = glGetUniformLocation(id, elementName.c_str());
+            }
+        }
+    }
+}
+
+/*
+    uniform lookup
+*/
+
+// cached location of a uniform (-1 if not active)
+GLint Shader::getUniformLocation(const std::string& name) {
+    std::unordered_map<std::string, GLint>::iterator it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
 }
 
 /*
@@ -64,39 +153,48 @@ void Shader::cleanup() {
 */
 
 void Shader::setBool(const std::string& name, bool value) {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
+    glUniform1i(getUniformLocation(name), (int)value);
+    GLStats::countUniform();
 }
 
 void Shader::setInt(const std::string& name, int value) {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1i(getUniformLocation(name), value);
+    GLStats::countUniform();
 }
 
 void Shader::setFloat(const std::string& name, float value) {
-    glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1f(getUniformLocation(name), value);
+    GLStats::countUniform();
 }
 
 void Shader::set3Float(const std::string& name, float v1, float v2, float v3) {
-    glUniform3f(glGetUniformLocation(id, name.c_str()), v1, v2, v3);
+    glUniform3f(getUniformLocation(name), v1, v2, v3);
+    GLStats::countUniform();
 }
 
 void Shader::set3Float(const std::string& name, glm::vec3 v) {
-    glUniform3f(glGetUniformLocation(id, name.c_str()), v.x, v.y, v.z);
+    glUniform3f(getUniformLocation(name), v.x, v.y, v.z);
+    GLStats::countUniform();
 }
 
 void Shader::set4Float(const std::string& name, float v1, float v2, float v3, float v4) {
-    glUniform4f(glGetUniformLocation(id, name.c_str()), v1, v2, v3, v4);
+    glUniform4f(getUniformLocation(name), v1, v2, v3, v4);
+    GLStats::countUniform();
 }
 
 void Shader::set4Float(const std::string& name, glm::vec4 v) {
-    glUniform4f(glGetUniformLocation(id, name.c_str()), v.x, v.y, v.z, v.w);
+    glUniform4f(getUniformLocation(name), v.x, v.y, v.z, v.w);
+    GLStats::countUniform();
 }
 
 void Shader::setMat3(const std::string& name, glm::mat3 val) {
-    glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(val));
+    glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(val));
+    GLStats::countUniform();
 }
 
 void Shader::setMat4(const std::string& name, glm::mat4 val) {
-    glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(val));
+    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(val));
+    GLStats::countUniform();
 }
 
 /*
@@ -106,24 +204,36 @@ void Shader::setMat4(const std::string& name, glm::mat4 val) {
 // compile shader program
 GLuint Shader::compileShader(bool includeDefaultHeader, const char* filePath, GLuint type) {
     // create shader from file
-    GLuint ret = glCreateShader(type);
     GLchar* shader = loadShaderSrc(includeDefaultHeader, filePath);
-    glShaderSource(ret, 1, &shader, NULL);
-    glCompileShader(ret);
+    GLuint ret = compileShaderSrc(shader, filePath, type);
     free(shader);
 
+    return ret;
+}
+
+// compile shader from source
+GLuint Shader::compileShaderSrc(const char* src, const char* label, GLuint type) {
+    TRACE_SCOPE_DETAIL("Shader::compile", "startup", label);
+
+    GLuint ret = glCreateShader(type);
+    glShaderSource(ret, 1, &src, NULL);
+    glCompileShader(ret);
+
     // catch compilation error
     int success;
     glGetShaderiv(ret, GL_COMPILE_STATUS, &success);
     if (!success) {
         char* infoLog = (char*)malloc(512);
         glGetShaderInfoLog(ret, 512, NULL, infoLog);
-        std::cout << "Error with shader comp." << filePath << ":" << std::endl << infoLog << std::endl;
+        std::cout << "Error with shader comp." << label << ":" << std::endl << infoLog << std::endl;
     }
 
     return ret;
 }
 
+// callbacks after linking
+std::vector<void(*)(Shader& shader)> Shader::linkCallbacks;
+
 // stream containing default headers
 std::stringstream Shader::defaultHeaders;
 
@@ -145,8 +255,7 @@ void Shader::clearDefault() {
 char* Shader::loadShaderSrc(bool includeDefaultHeader, const char* filePath) {
     std::string fullPath = Shader::defaultDirectory + '/' + filePath;
 
-    FILE* file = NULL;
-    fopen_s(&file, fullPath.c_str(), "rb");
+    FILE* file = fopen(fullPath.c_str(), "rb");
     if (!file) {
         std::cout << "Could not open " << filePath << std::endl;
         return NULL;
@@ -166,7 +275,7 @@ char* Shader::loadShaderSrc(bool includeDefaultHeader, const char* filePath) {
         // copy header and advance cursor to read into space after default header
         cursor = Shader::defaultHeaders.str().size();
         ret = (char*)malloc(cursor + len + 1);
-        memcpy_s(ret, cursor + len + 1, Shader::defaultHeaders.str().c_str(), cursor);
+        memcpy(ret, Shader::defaultHeaders.str().c_str(), cursor);
     }
     else {
         ret = (char*)malloc(len + 1);
@@ -174,6 +283,7 @@ char* Shader::loadShaderSrc(bool includeDefaultHeader, const char* filePath) {
     // read from file
     fread(ret + cursor, 1, len, file);
     ret[cursor + len] = 0; // terminator
+    fclose(file);
 
     return ret;
 }
\ No newline at end of file
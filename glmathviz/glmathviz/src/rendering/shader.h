@@ -6,11 +6,78 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../profiling/glstats.h"
+
+/*
+    handle to a resolved uniform location
+    - resolve once with Shader::getUniform, then set without a lookup
+    - applies to the currently active shader
+*/
+
+template <typename T>
+class UniformHandle {
+public:
+    GLint location;
+
+    UniformHandle(GLint location = -1)
+        : location(location) {}
+
+    // if the uniform is active in the shader
+    bool valid() {
+        return location >= 0;
+    }
+
+    // set value (specialized for each supported type)
+    void set(const T& val);
+};
+
+template <> inline void UniformHandle<bool>::set(const bool& val) {
+    glUniform1i(location, (int)val);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<int>::set(const int& val) {
+    glUniform1i(location, val);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<float>::set(const float& val) {
+    glUniform1f(location, val);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<glm::vec2>::set(const glm::vec2& val) {
+    glUniform2f(location, val.x, val.y);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<glm::vec3>::set(const glm::vec3& val) {
+    glUniform3f(location, val.x, val.y, val.z);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<glm::vec4>::set(const glm::vec4& val) {
+    glUniform4f(location, val.x, val.y, val.z, val.w);
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<glm::mat3>::set(const glm::mat3& val) {
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(val));
+    GLStats::countUniform();
+}
+
+template <> inline void UniformHandle<glm::mat4>::set(const glm::mat4& val) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(val));
+    GLStats::countUniform();
+}
+
 /*
     class to represent shader program
 */
@@ -20,6 +87,12 @@ public:
     // program ID
     unsigned int id;
 
+    // locations of the active uniforms, reflected at link time
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    // outputs captured with transform feedback (interleaved), set before generating
+    std::vector<const char*> feedbackVaryings;
+
     /*
         constructors
     */
@@ -43,12 +116,37 @@ public:
         const char* fragShaderPath,
         const char* geoShaderPath = nullptr);
 
+    // generate with an additional shader object compiled from source
+    // - lets a stage link against generated functions declared in its file
+    void generate(bool includeDefaultHeader,
+        const char* vertexShaderPath,
+        const char* fragShaderPath,
+        const char* geoShaderPath,
+        GLenum generatedType,
+        const std::string& generatedSrc);
+
     // activate shader
     void activate();
 
     // cleanup
     void cleanup();
 
+    // read all active uniform locations (called after linking)
+    void reflectUniforms();
+
+    /*
+        uniform lookup
+    */
+
+    // cached location of a uniform (-1 if not active)
+    GLint getUniformLocation(const std::string& name);
+
+    // resolve typed handle to a uniform
+    template <typename T>
+    UniformHandle<T> getUniform(const std::string& name) {
+        return UniformHandle<T>(getUniformLocation(name));
+    }
+
     /*
         set uniform variables
     */
@@ -70,6 +168,12 @@ public:
     // compile shader program
     static GLuint compileShader(bool includeDefaultHeader, const char* filePath, GLuint type);
 
+    // compile shader from source (label is used in errors and traces)
+    static GLuint compileShaderSrc(const char* src, const char* label, GLuint type);
+
+    // called for every program after linking (e.g. to bind uniform blocks)
+    static std::vector<void(*)(Shader& shader)> linkCallbacks;
+
     // default directory
     static std::string defaultDirectory;
 
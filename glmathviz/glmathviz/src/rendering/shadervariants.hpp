@@ -0,0 +1,52 @@
+#ifndef SHADERVARIANTS_HPP
+#define SHADERVARIANTS_HPP
+
+#include <string>
+#include <unordered_map>
+
+#include "shader.h"
+
+typedef struct {
+    std::string source;
+    Shader shader;
+} ShaderVariant;
+
+/*
+    cache of compiled shader variants keyed by a hash of their generated source
+    - a variant is compiled once, switching back to it only rebinds
+    - the stored source is compared on a hit, a colliding variant is replaced
+*/
+
+class ShaderVariants {
+public:
+    std::unordered_map<unsigned long long, ShaderVariant> variants;
+
+    // get cached variant compiled from source, null if not compiled yet
+    Shader* find(unsigned long long key, const std::string& source) {
+        std::unordered_map<unsigned long long, ShaderVariant>::iterator it = variants.find(key);
+        return it != variants.end() && it->second.source == source ? &it->second.shader : nullptr;
+    }
+
+    // store a compiled variant
+    Shader* add(unsigned long long key, const std::string& source, Shader shader) {
+        std::unordered_map<unsigned long long, ShaderVariant>::iterator it = variants.find(key);
+        if (it != variants.end()) {
+            it->second.shader.cleanup();
+        }
+
+        ShaderVariant& variant = variants[key];
+        variant.source = source;
+        variant.shader = shader;
+        return &variant.shader;
+    }
+
+    // delete all variants
+    void cleanup() {
+        for (auto& pair : variants) {
+            pair.second.shader.cleanup();
+        }
+        variants.clear();
+    }
+};
+
+#endif
@@ -1,6 +1,11 @@
 #ifndef TRANSITION_H
 #define TRANSITION_H
 
+#include <glm/glm.hpp>
+#include <limits>
+
+#include "../math/dual.hpp"
+
 template <typename T>
 class Transition {
 private:
@@ -17,11 +22,16 @@ protected:
 	// function to be overridden in subclasses
 	virtual T calculateNew(double t) { return end; }
 
+	// normalized time [0, 1]
+	double getProgress() {
+		return cur_t;
+	}
+
 public:
 	Transition(T start, T end, double duration)
 		: start(start), end(end), cur(start),
 		duration(duration), cur_t(0.0), 
-		running(false) { }
+		running(false), cyclical(false) { }
 
 	void update(double dt) {
 		if (running) {
@@ -48,6 +58,15 @@ public:
 		return duration;
 	}
 
+	// seconds until the current value next changes (0 = every frame, infinity = never)
+	virtual double nextChange() {
+		if (running && (cyclical || cur_t < 1.0)) {
+			return 0.0;
+		}
+
+		return std::numeric_limits<double>::infinity();
+	}
+
 	void toggleRunning() {
 		running = !running;
 	}
@@ -109,6 +128,16 @@ class StepTransition : public ProportionalTransition<T> {
 	}
 
 public:
+	// only changes at step boundaries
+	double nextChange() {
+		if (Transition<T>::nextChange() > 0.0) {
+			return Transition<T>::nextChange();
+		}
+
+		double nextStep = (floor(this->getProgress() * (double)noSteps) + 1.0) / (double)noSteps;
+		return (nextStep - this->getProgress()) * this->getDuration();
+	}
+
 	StepTransition(T start, T end, double duration, unsigned int noSteps)
 		: ProportionalTransition<T>(start, end, duration) {
 		this->noSteps = noSteps > 0 ? noSteps : 1;
@@ -177,23 +206,68 @@ public:
 		P0(start), P1(P1), P2(P2), P3(end) { }
 };
 
-typedef glm::vec3(*path_func)(double t);
+// path parameter carrying the first and second derivative through the function (see Dual)
+typedef Dual<Dual<double>> PathParam;
+typedef glm::tvec3<PathParam>(*path_func)(PathParam t);
 class ParametrizedPath : public Transition<glm::vec3> {
 	path_func func;
 
 	double t0;
 	double t1;
 
+	// Frenet frame at the last calculated point (normal and binormal are zero where the path is straight)
+	glm::vec3 tangent;
+	glm::vec3 normal;
+	glm::vec3 binormal;
+
+	static glm::tvec3<PathParam> sample(path_func func, double t) {
+		return func(PathParam::variable(Dual<double>::variable(t)));
+	}
+
+	static glm::vec3 position(const glm::tvec3<PathParam>& r) {
+		return glm::vec3(r.x.val.val, r.y.val.val, r.z.val.val);
+	}
+
+	// position at parameter t, the frame from the derivatives of the same evaluation
+	glm::vec3 evaluate(double t) {
+		glm::tvec3<PathParam> r = sample(func, t);
+		glm::dvec3 velocity(r.x.val.der, r.y.val.der, r.z.val.der);
+		glm::dvec3 acceleration(r.x.der.der, r.y.der.der, r.z.der.der);
+
+		double speed = glm::length(velocity);
+		glm::dvec3 b = glm::cross(velocity, acceleration);
+		double bLength = glm::length(b);
+		tangent = speed > 0.0 ? glm::vec3(velocity / speed) : glm::vec3(0.0f);
+		binormal = bLength > 0.0 ? glm::vec3(b / bLength) : glm::vec3(0.0f);
+		normal = glm::cross(binormal, tangent);
+
+		return position(r);
+	}
+
 	glm::vec3 calculateNew(double t) {
 		// LERP between t0 and t1
 		t = t0 + t * (t1 - t0);
-		return func(t);
+		return evaluate(t);
 	}
 
 public:
 	ParametrizedPath(path_func func, double t0, double t1, double duration)
-		: Transition<glm::vec3>(func(t0), func(t1), duration),
-		t0(t0), t1(t1), func(func) {}
+		: Transition<glm::vec3>(position(sample(func, t0)), position(sample(func, t1)), duration),
+		t0(t0), t1(t1), func(func) {
+		evaluate(t0);
+	}
+
+	glm::vec3 getTangent() {
+		return tangent;
+	}
+
+	glm::vec3 getNormal() {
+		return normal;
+	}
+
+	glm::vec3 getBinormal() {
+		return binormal;
+	}
 };
 
 #endif // TRANSITION_H
\ No newline at end of file
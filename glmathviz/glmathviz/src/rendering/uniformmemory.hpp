@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <string>
+#include <string.h>
 
 #include "vertexmemory.hpp"
 #include "shader.h"
@@ -195,16 +196,22 @@ namespace UBO {
             : BufferObject(GL_UNIFORM_BUFFER),
             block(newStruct({})),
             calculatedSize(0),
-            bindingPos(UBO::nextBindingPos++) {}
+            bindingPos(UBO::nextBindingPos++),
+            staged(false) {}
 
         UBO(std::vector<Element> elements)
             : BufferObject(GL_UNIFORM_BUFFER),
             block(newStruct(elements)),
             calculatedSize(0),
-            bindingPos(UBO::nextBindingPos++) {}
+            bindingPos(UBO::nextBindingPos++),
+            staged(false) {}
 
         void attachToShader(Shader shader, std::string name) {
             GLuint blockIdx = glGetUniformBlockIndex(shader.id, name.c_str());
+            if (blockIdx == GL_INVALID_INDEX) {
+                // shader does not use this block
+                return;
+            }
             glUniformBlockBinding(shader.id, blockIdx, bindingPos);
         }
 
@@ -240,13 +247,34 @@ namespace UBO {
         std::vector<std::pair<unsigned int, Element*>> indexStack; // stack to keep track of the nested indices
         int currentDepth; // current size of the stack - 1
 
+        // staged writes are collected in memory and uploaded with one call in endWrite
+        bool staged;
+        std::vector<unsigned char> stagingData;
+
         // initialize iterator
-        void startWrite() {
+        void startWrite(bool staged = false) {
             currentDepth = 0;
             offset = 0;
             poppedOffset = 0;
             indexStack.clear();
             indexStack.push_back({ 0, &block });
+
+            this->staged = staged;
+            if (staged) {
+                if (!calculatedSize) {
+                    calculatedSize = calcSize();
+                }
+                stagingData.resize(calculatedSize);
+            }
+        }
+
+        // upload staged data (buffer must be bound)
+        void endWrite() {
+            if (staged) {
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, calculatedSize, &stagingData[0]);
+                GLStats::countUpload(calculatedSize);
+                staged = false;
+            }
         }
 
         // next element in iteration
@@ -313,7 +341,13 @@ namespace UBO {
             offset = roundUpPow2(offset, element.alignPow2());
             //std::cout << offset << std::endl;
 
-            glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(T), data);
+            if (staged) {
+                memcpy(&stagingData[offset], data, sizeof(T));
+            }
+            else {
+                glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(T), data);
+                GLStats::countUpload(sizeof(T));
+            }
 
             if (poppedOffset) {
                 offset = poppedOffset;
@@ -0,0 +1,107 @@
+#ifndef UPLOADLIST_HPP
+#define UPLOADLIST_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <functional>
+#include <string.h>
+
+#include "shader.h"
+#include "vertexmemory.hpp"
+#include "../profiling/glstats.h"
+
+/*
+    list of GPU writes recorded off the GL thread
+    - Program::update may run on a worker, so it records buffer updates and uniform sets here
+    - data is copied when recorded, replay executes the writes on the GL thread and clears the list
+    - passes recorded with run (e.g. render to texture) replay after the writes, before any draws are queued
+*/
+
+class UploadList {
+public:
+    /*
+        recording
+    */
+
+    // record BufferObject::updateData (offset in bytes)
+    template<typename T>
+    void updateData(BufferObject& buffer, GLintptr offset, GLuint noElements, T* data) {
+        GLsizeiptr size = noElements * sizeof(T);
+        size_t dataOffset = staging.size();
+        staging.resize(dataOffset + size);
+        memcpy(&staging[dataOffset], data, size);
+
+        bufferUploads.push_back({ buffer.type, buffer.val, offset, size, dataOffset });
+    }
+
+    // record uniform set on a shader (value captured by copy)
+    template<typename T>
+    void setUniform(Shader& shader, UniformHandle<T> handle, T val) {
+        Shader* target = &shader;
+        uniformSets.push_back([target, handle, val]() mutable {
+            target->activate();
+            handle.set(val);
+        });
+    }
+
+    // record a GL pass that depends on the recorded writes
+    void run(std::function<void()> pass) {
+        passes.push_back(pass);
+    }
+
+    // if nothing was recorded
+    bool empty() {
+        return bufferUploads.empty() && uniformSets.empty() && passes.empty();
+    }
+
+    /*
+        replay (GL thread)
+    */
+
+    void replay() {
+        for (BufferUpload& upload : bufferUploads) {
+            if (upload.type == GL_ELEMENT_ARRAY_BUFFER) {
+                // do not rebind the element buffer of whichever VAO is bound
+                ArrayObject::clear();
+            }
+            glBindBuffer(upload.type, upload.buffer);
+            glBufferSubData(upload.type, upload.offset, upload.size, &staging[upload.dataOffset]);
+            GLStats::countUpload(upload.size);
+        }
+
+        for (std::function<void()>& set : uniformSets) {
+            set();
+        }
+
+        for (std::function<void()>& pass : passes) {
+            pass();
+        }
+
+        clear();
+    }
+
+    // discard recorded writes (keeps capacity)
+    void clear() {
+        staging.clear();
+        bufferUploads.clear();
+        uniformSets.clear();
+        passes.clear();
+    }
+
+private:
+    typedef struct {
+        GLenum type;
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+        size_t dataOffset; // into staging
+    } BufferUpload;
+
+    std::vector<unsigned char> staging;
+    std::vector<BufferUpload> bufferUploads;
+    std::vector<std::function<void()>> uniformSets;
+    std::vector<std::function<void()>> passes;
+};
+
+#endif
@@ -6,6 +6,8 @@
 
 #include <map>
 
+#include "../profiling/glstats.h"
+
 /*
     class for buffer objects
     - VBOs, EBOs, etc
@@ -40,12 +42,14 @@ public:
     template<typename T>
     void setData(GLuint noElements, T* data, GLenum usage) {
         glBufferData(type, noElements * sizeof(T), data, usage);
+        GLStats::countUpload(data ? noElements * sizeof(T) : 0);
     }
 
     // update data (glBufferSubData)
     template<typename T>
     void updateData(GLintptr offset, GLuint noElements, T* data) {
         glBufferSubData(type, offset, noElements * sizeof(T), data);
+        GLStats::countUpload(noElements * sizeof(T));
     }
 
     // set attribute pointers
@@ -95,16 +99,19 @@ public:
     // bind
     void bind() {
         glBindVertexArray(val);
+        GLStats::countVAO();
     }
 
     // draw arrays
     void draw(GLenum mode, GLuint first, GLuint count, GLuint instancecount = 1) {
         glDrawArraysInstanced(mode, first, count, instancecount);
+        GLStats::countDraw();
     }
 
     // draw
     void draw(GLenum mode, GLuint count, GLenum type, GLint indices, GLuint instancecount = 1) {
         glDrawElementsInstanced(mode, count, type, (void*)indices, instancecount);
+        GLStats::countDraw();
     }
 
     // cleanup
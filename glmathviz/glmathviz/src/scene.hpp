@@ -0,0 +1,236 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "rendering/shader.h"
+#include "rendering/uniformmemory.hpp"
+#include "rendering/drawqueue.hpp"
+
+#include "programs/arrow.hpp"
+#include "programs/rectangle.hpp"
+#include "programs/sphere.hpp"
+#include "programs/surface.hpp"
+#include "programs/parametricsurface.hpp"
+#include "programs/implicitsurface.hpp"
+#include "programs/complexplane.hpp"
+#include "programs/vectorfield.hpp"
+#include "programs/path.hpp"
+
+#include "profiling/programtimer.h"
+#include "profiling/tracer.h"
+
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+/*
+	scene graph shared by the windowed app and the headless benchmark
+	- include from exactly one translation unit per executable
+*/
+
+// GLOBAL PROGRAMS
+std::vector<Program*> programs;
+DrawQueue drawQueue;
+std::vector<const char*> programNames;
+Rectangle rect;
+Arrow arrow(5);
+Surface surface(5, 500, 500);
+ParametricSurface parametric(16, 64, 32);
+ImplicitSurface implicit;
+ComplexPlane complexPlane;
+VectorField vectorField;
+//Transition<glm::vec3>* transitionPath = new CubicBezierPath<glm::vec3>(
+//	glm::vec3(0.0f),
+//	glm::vec3(1.0f),
+//	glm::vec3(-3.0f, -1.0f, 2.5f),
+//	glm::vec3(2.0f),
+//	3.0);
+glm::tvec3<PathParam> func(PathParam t) {
+	return { 0.0, 3*cos(t) - 3.0, sin(t) };
+}
+ParametrizedPath* transitionPath = new ParametrizedPath(
+	func,
+	0.0, glm::two_pi<double>(),
+	2.0
+	);
+Sphere sphere(transitionPath, 10);
+Path path(transitionPath, 200);
+
+typedef struct {
+	glm::vec3 dir;
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+} DirLight;
+
+// CAMERA (written once per frame)
+UBO::UBO cameraUBO({
+	UBO::newColMat(4, 4),	// projView
+	UBO::Type::VEC3			// viewPos
+});
+
+// LIGHTING
+UBO::UBO dirLightUBO({
+	UBO::newStruct({
+		UBO::Type::VEC3,
+		UBO::Type::VEC4,
+		UBO::Type::VEC4,
+		UBO::Type::VEC4
+	})
+});
+
+void registerProgram(Program* program, const char* name) {
+	programs.push_back(program);
+	programNames.push_back(name);
+	ProgramTimer::registerProgram(program, name);
+}
+
+// bind the shared uniform blocks of every linked shader (including variants generated later)
+void attachUniformBlocks(Shader& shader) {
+	cameraUBO.attachToShader(shader, "CameraUniform");
+	dirLightUBO.attachToShader(shader, "DirLightUniform");
+}
+
+// scenes selectable at startup (app: first argument, bench: --scene)
+const char* const sceneNames[] = { "surface", "parametric", "implicit", "complex", "vectorfield" };
+
+// generate instances and register the programs of one of sceneNames
+void registerScene(const std::string& scene) {
+	// axes in every scene
+	arrow.addInstance(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0125f, 0.025f, 0.15f, Material::red_plastic);
+	arrow.addInstance(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0125f, 0.025f, 0.15f, Material::green_plastic);
+	arrow.addInstance(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0125f, 0.025f, 0.15f, Material::cyan_plastic);
+	registerProgram(&arrow, "arrow");
+
+	if (scene == "surface") {
+		sphere.addInstance(glm::vec3(0.0f), glm::vec3(0.05f), Material::bronze);
+		// velocity of the sphere
+		arrow.addPathInstance(transitionPath, 0.4f, 0.0125f, 0.025f, 0.1f, Material::bronze);
+		surface.addInstance(glm::vec2(-10.f), glm::vec2(10.f), Material::yellow_plastic);
+		//surface.addInstance(glm::vec2(-2.5f, -100.0f), glm::vec2(2.5f, -2.5f), Material::red_plastic);
+		//surface.addInstance(glm::vec2(-2.5f, -100.0f), glm::vec2(-50.0f, 100.0f), Material::jade);
+
+		registerProgram(&path, "path");
+		registerProgram(&sphere, "sphere");
+		registerProgram(&surface, "surface");
+		//registerProgram(&rect, "rectangle");
+	}
+	else if (scene == "parametric") {
+		// domain split into alternating strips in front of the camera
+		for (int i = 0; i < 4; i++) {
+			glm::vec4 d = parametric.domain();
+			float w = (d.z - d.x) / 4.0f;
+			parametric.addInstance(glm::vec2(d.x + i * w, d.y), glm::vec2(d.x + (i + 1) * w, d.w),
+				i % 2 ? Material::jade : Material::pearl, glm::vec3(4.0f, 0.0f, 0.0f));
+		}
+
+		registerProgram(&parametric, "parametric");
+	}
+	else if (scene == "implicit") {
+		implicit.setMaterial(Material::jade);
+
+		registerProgram(&implicit, "implicit");
+	}
+	else if (scene == "complex") {
+		registerProgram(&complexPlane, "complex plane");
+	}
+	else if (scene == "vectorfield") {
+		registerProgram(&vectorField, "vector field");
+	}
+}
+
+// generate instances, load programs and write lighting (requires a current GL context)
+// - returns false for an unknown scene, nothing is loaded then
+bool loadScene(const char* scene = sceneNames[0]) {
+	bool found = false;
+	for (const char* name : sceneNames) {
+		found |= !strcmp(name, scene);
+	}
+	if (!found) {
+		std::cout << "Unknown scene \"" << scene << "\", available:";
+		for (const char* name : sceneNames) {
+			std::cout << " " << name;
+		}
+		std::cout << std::endl;
+		return false;
+	}
+
+	registerScene(scene);
+
+	transitionPath->setCyclical();
+
+	Shader::linkCallbacks.push_back(attachUniformBlocks);
+
+	// setup programs
+	for (unsigned int i = 0; i < programs.size(); i++) {
+		TRACE_SCOPE_DETAIL("Program::load", "startup", programNames[i]);
+		programs[i]->load();
+	}
+
+	// camera
+	cameraUBO.generate();
+	cameraUBO.bind();
+	cameraUBO.initNullData(GL_DYNAMIC_DRAW);
+	cameraUBO.bindRange();
+
+	// lighting
+	DirLight dirLight = {
+		glm::vec3(-0.2f, -0.9f, -0.2f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
+		glm::vec4(0.75f, 0.75f, 0.75f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)
+	};
+	// generate/bind
+	dirLightUBO.generate();
+	dirLightUBO.bind();
+	dirLightUBO.initNullData(GL_STATIC_DRAW);
+	dirLightUBO.bindRange();
+	// write
+	dirLightUBO.startWrite();
+	dirLightUBO.writeElement<glm::vec3>(&dirLight.dir);
+	dirLightUBO.writeElement<glm::vec4>(&dirLight.ambient);
+	dirLightUBO.writeElement<glm::vec4>(&dirLight.diffuse);
+	dirLightUBO.writeElement<glm::vec4>(&dirLight.specular);
+
+	return true;
+}
+
+// write camera block shared by all programs (one upload) and notify the programs
+void writeCamera(glm::mat4 projView, glm::vec3 viewPos) {
+	cameraUBO.bind();
+	cameraUBO.startWrite(true);
+	cameraUBO.writeArrayContainer<glm::mat4, glm::vec4>(&projView, 4);
+	cameraUBO.writeElement<glm::vec3>(&viewPos);
+	cameraUBO.endWrite();
+
+	for (Program* program : programs) {
+		program->cameraChanged(projView, viewPos);
+	}
+}
+
+// framebuffer size in pixels, on startup and on every resize
+void writeViewport(int width, int height) {
+	for (Program* program : programs) {
+		program->viewportChanged(width, height);
+	}
+}
+
+// cleanup programs
+void cleanupScene() {
+	for (Program* program : programs) {
+		program->cleanup();
+	}
+
+	cameraUBO.cleanup();
+	dirLightUBO.cleanup();
+	Shader::linkCallbacks.clear();
+	ProgramTimer::cleanupAll();
+
+	programs.clear();
+	programNames.clear();
+}
+
+#endif // SCENE_HPP
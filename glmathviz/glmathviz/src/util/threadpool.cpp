@@ -0,0 +1,125 @@
+#include "threadpool.h"
+
+#include <memory>
+
+/*
+    shared state of one parallelFor call
+    - kept alive by the helper tasks, so late helpers never touch the caller's stack
+*/
+
+typedef struct {
+    std::function<void(unsigned int)> job;
+    unsigned int count;
+    std::atomic<unsigned int> next;
+    std::atomic<unsigned int> done;
+    std::mutex mutex;
+    std::condition_variable finished;
+} ParallelRange;
+
+// take indices until the range is exhausted
+void runRange(ParallelRange& range) {
+    unsigned int i;
+    while ((i = range.next.fetch_add(1)) < range.count) {
+        range.job(i);
+
+        if (range.done.fetch_add(1) + 1 == range.count) {
+            std::lock_guard<std::mutex> lock(range.mutex);
+            range.finished.notify_all();
+        }
+    }
+}
+
+/*
+    constructor
+*/
+
+ThreadPool::ThreadPool(int noWorkers)
+    : stopping(false) {
+    if (noWorkers < 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        noWorkers = hardware > 1 ? (int)hardware - 1 : 0;
+    }
+
+    for (int i = 0; i < noWorkers; i++) {
+        workers.push_back(std::thread(&ThreadPool::work, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/*
+    jobs
+*/
+
+void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int)>& job) {
+    if (!count) {
+        return;
+    }
+
+    // nothing to share, run inline
+    if (workers.empty() || count == 1) {
+        for (unsigned int i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::shared_ptr<ParallelRange> range = std::make_shared<ParallelRange>();
+    range->job = job;
+    range->count = count;
+    range->next = 0;
+    range->done = 0;
+
+    // wake helpers, the caller takes one share itself
+    unsigned int noHelpers = count - 1 < (unsigned int)workers.size() ? count - 1 : (unsigned int)workers.size();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (unsigned int i = 0; i < noHelpers; i++) {
+            tasks.push([range]() { runRange(*range); });
+        }
+    }
+    taskAvailable.notify_all();
+
+    runRange(*range);
+
+    // wait for indices still running on helpers
+    std::unique_lock<std::mutex> lock(range->mutex);
+    range->finished.wait(lock, [&range]() { return range->done.load() == range->count; });
+}
+
+unsigned int ThreadPool::size() {
+    return (unsigned int)workers.size();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+    fixed size pool of worker threads
+    - parallelFor splits an index range across the workers and the calling thread
+    - no GL calls may be made from jobs (the context is only current on the main thread)
+*/
+
+class ThreadPool {
+public:
+    /*
+        constructor
+    */
+
+    // start workers (negative = one less than the number of hardware threads, 0 = run everything on the caller)
+    ThreadPool(int noWorkers = -1);
+
+    // join workers
+    ~ThreadPool();
+
+    /*
+        jobs
+    */
+
+    // run job(i) for every i in [0, count), returns when all have finished
+    // - safe to call from inside a job, the caller always works on the range itself
+    void parallelFor(unsigned int count, const std::function<void(unsigned int)>& job);
+
+    // number of worker threads (not counting the caller)
+    unsigned int size();
+
+    /*
+        static
+    */
+
+    // pool shared by the whole application
+    static ThreadPool& shared();
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    bool stopping;
+
+    // worker loop
+    void work();
+};
+
+#endif